@@ -0,0 +1,430 @@
+// See COPYING file for licensing information.
+/**
+ * \file backjump.cpp
+ * Implementation of the search with conflict-directed backjumping and nogood learning.
+ */
+#include "backjump.h"
+#include "tables.h"
+#include "trace.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Returns an empty set of levels.
+	 */
+	static inline Culprits nobody() {
+		Culprits culprits = {{0, 0}};
+
+		return culprits;
+	}
+
+	/**
+	 * Returns the set holding only a level.
+	 */
+	static inline Culprits only(short unsigned int level) {
+		Culprits culprits = nobody();
+
+		culprits.Bits[level >> 6] = 1ULL << (level & 63);
+		return culprits;
+	}
+
+	/**
+	 * Adds the levels of a set to another one.
+	 */
+	static inline void blame(Culprits& culprits, const Culprits& more) {
+		culprits.Bits[0] |= more.Bits[0];
+		culprits.Bits[1] |= more.Bits[1];
+	}
+
+	/**
+	 * States if a level is in a set.
+	 */
+	static inline bool guilty(const Culprits& culprits, short unsigned int level) {
+		return (culprits.Bits[level >> 6] >> (level & 63)) & 1;
+	}
+
+	/**
+	 * Backjumper constructor. It has nothing to solve till load() is called.
+	 */
+	Backjumper::Backjumper()
+		: Unsolved(0), Limits(0), Stopped(false), Nodes(0), Jumps(0)
+	{
+		for(short unsigned int c = 0; c < 81; c++) {
+			Candidates[c] = 0;
+			Values[c] = 0;
+		}
+	}
+
+	/**
+	 * Starts a new search from a grid, forgetting the nogoods of the last one.
+	 * \arg		grid	state to solve
+	 * \return	false if some cell has no candidate
+	 */
+	bool Backjumper::load(const Grid& grid) {
+		Unsolved = 0;
+		for(short unsigned int c = 0; c < 81; c++) {
+			Candidates[c] = grid.getCandidates(c);
+			Values[c] = grid.get(c);
+			Why[c] = nobody();
+			for(short unsigned int v = 0; v < 9; v++)
+				Reasons[c][v] = nobody();
+
+			if(Values[c] == 0)
+				Unsolved++;
+			if(Candidates[c] == 0)
+				return false;
+		}
+
+		Trail.clear();
+		Nogoods.clear();
+		for(short unsigned int l = 0; l < 729; l++)
+			Watches[l].clear();
+		Stopped = false;
+		Nodes = Jumps = 0;
+
+		return true;
+	}
+
+	/**
+	 * Sets the value of a cell and propagates it, like Grid::assign.
+	 * \arg		cell		index of the cell within the board, in the range [0,80]
+	 * \arg		myP			the value to set, in the range [1,9]
+	 * \arg		why			levels it follows from
+	 * \arg		conflict	set to the levels to blame if it leads to a contradiction
+	 * \return	false if it leads to a contradiction
+	 */
+	bool Backjumper::assign(short unsigned int cell, short unsigned int myP, const Culprits& why, Culprits& conflict) {
+		short unsigned int bit = 1 << (myP - 1);
+
+		if(!(Candidates[cell] & bit)) {
+			conflict = why;
+			blame(conflict, Reasons[cell][myP - 1]);
+			return false;
+		} else if(Values[cell] == myP)
+			return true;
+
+		Values[cell] = myP;
+		Why[cell] = why;
+		Unsolved--;
+		Trail.push_back(729 + cell);
+
+		short unsigned int others = Candidates[cell] & ~bit;
+
+		for(; others; others &= others - 1)
+			if(!exclude(cell, __builtin_ctz(others) + 1, why, conflict))
+				return false;
+
+		for(short unsigned int i = 0; i < 20; i++)
+			if(!exclude(Peers[cell][i], myP, why, conflict))
+				return false;
+
+		return check(cell * 9 + myP - 1, conflict);
+	}
+
+	/**
+	 * Removes a candidate from a cell and propagates it, like Grid::eliminate. A cell left with a
+	 * single candidate, or a value with a single place, follows from the levels of all the other
+	 * removals in the cell, or in the unit.
+	 * \arg		cell		index of the cell within the board, in the range [0,80]
+	 * \arg		myP			the value to remove, in the range [1,9]
+	 * \arg		why			levels it follows from
+	 * \arg		conflict	set to the levels to blame if it leads to a contradiction
+	 * \return	false if the cell or one of its units is left with no place for a value
+	 */
+	bool Backjumper::exclude(short unsigned int cell, short unsigned int myP, const Culprits& why, Culprits& conflict) {
+		short unsigned int bit = 1 << (myP - 1);
+
+		if(!(Candidates[cell] & bit))
+			return true;
+
+		Candidates[cell] &= ~bit;
+		Reasons[cell][myP - 1] = why;
+		Trail.push_back(cell * 9 + myP - 1);
+
+		if(Candidates[cell] == 0 || (Values[cell] == 0 && !(Candidates[cell] & (Candidates[cell] - 1)))) {
+			Culprits culprits = nobody();
+
+			for(short unsigned int v = 0; v < 9; v++)
+				if(!(Candidates[cell] & (1 << v)))
+					blame(culprits, Reasons[cell][v]);
+
+			if(Candidates[cell] == 0) {
+				conflict = culprits;
+				return false;
+			} else if(!assign(cell, __builtin_ctz(Candidates[cell]) + 1, culprits, conflict))
+				return false;
+		}
+
+		// The removed value must still fit somewhere in each unit of the cell
+		for(short unsigned int kind = 0; kind < 3; kind++) {
+			const unsigned char* unit = UnitCells[CellUnits[cell][kind]];
+			short unsigned int places = 0, place = 0;
+
+			for(short unsigned int i = 0; i < 9 && places < 2; i++)
+				if(Candidates[unit[i]] & bit) {
+					places++;
+					place = unit[i];
+				}
+
+			if(places == 0 || (places == 1 && Values[place] == 0)) {
+				Culprits culprits = nobody();
+
+				for(short unsigned int i = 0; i < 9; i++)
+					if(places == 0 || unit[i] != place)
+						blame(culprits, Reasons[unit[i]][myP - 1]);
+
+				if(places == 0) {
+					conflict = culprits;
+					return false;
+				} else if(!assign(place, myP, culprits, conflict))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Applies the nogoods holding a value just set: a nogood whose other values are all set rules
+	 * out its last one, and one whose values are all set is a contradiction.
+	 * \arg		literal		cell * 9 + value - 1 of the value set
+	 * \arg		conflict	set to the levels to blame if it leads to a contradiction
+	 * \return	false if it leads to a contradiction
+	 */
+	bool Backjumper::check(short unsigned int literal, Culprits& conflict) {
+		const vector<unsigned int>& watching = Watches[literal];
+
+		for(size_t n = 0; n < watching.size(); n++) {
+			const vector<short unsigned int>& nogood = Nogoods[watching[n]];
+			Culprits why = nobody();
+			short unsigned int open = 729;
+			bool idle = false;
+
+			for(size_t i = 0; i < nogood.size() && !idle; i++) {
+				short unsigned int c = nogood[i] / 9, v = nogood[i] % 9;
+
+				if(Values[c] == v + 1)
+					blame(why, Why[c]);
+				else if(!(Candidates[c] & (1 << v)) || open != 729)
+					idle = true;
+				else
+					open = nogood[i];
+			}
+
+			if(idle)
+				continue;
+			else if(open == 729) {
+				conflict = why;
+				return false;
+			} else if(!exclude(open / 9, open % 9 + 1, why, conflict))
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Keeps the nogood made of a value and of the decisions ruling it out, unless it's too long or
+	 * there are already too many of them.
+	 * \arg		literal		cell * 9 + value - 1 of the value ruled out
+	 * \arg		culprits	levels of the decisions ruling it out
+	 */
+	void Backjumper::learn(short unsigned int literal, const Culprits& culprits) {
+		vector<short unsigned int> nogood(1, literal);
+
+		if(Nogoods.size() >= MaxNogoods)
+			return;
+
+		for(short unsigned int level = 1; level < 128; level++)
+			if(guilty(culprits, level)) {
+				if(nogood.size() == MaxNogoodSize)
+					return;
+				nogood.push_back(Decisions[level]);
+			}
+
+		for(size_t i = 0; i < nogood.size(); i++)
+			Watches[nogood[i]].push_back(Nogoods.size());
+		Nogoods.push_back(nogood);
+	}
+
+	/**
+	 * Undoes the removals and the values set since the trail had a given size.
+	 */
+	void Backjumper::undo(size_t mark) {
+		while(Trail.size() > mark) {
+			short unsigned int entry = Trail.back();
+
+			Trail.pop_back();
+			if(entry >= 729) {
+				Values[entry - 729] = 0;
+				Unsolved++;
+			} else
+				Candidates[entry / 9] |= 1 << (entry % 9);
+		}
+	}
+
+	/**
+	 * Chooses the undecided cell with the fewest candidates, like Grid::choose.
+	 */
+	short unsigned int Backjumper::choose() const {
+		short unsigned int best = 81, fewest = 10;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(Values[c] == 0) {
+				short unsigned int n = __builtin_popcount(Candidates[c]);
+
+				if(n < fewest) {
+					fewest = n;
+					best = c;
+					if(n == 2)
+						break;
+				}
+			}
+
+		return best;
+	}
+
+	/**
+	 * Tries every value of a cell at a decision level.
+	 * A value failing for reasons not involving this level makes the whole level fail for the same
+	 * reasons, which jumps back over it; otherwise the reasons, this level aside, rule the value
+	 * out and are learnt as a nogood.
+	 * \arg		level		decision level, from 1
+	 * \arg		conflict	set to the levels to blame if every value fails
+	 * \return	true once solved; false if every value failed or the budget is exceeded
+	 */
+	bool Backjumper::descend(short unsigned int level, Culprits& conflict) {
+		if(Unsolved == 0)
+			return true;
+
+		if(!Limits->spend()) {
+			Stopped = true;
+			return false;
+		}
+		Nodes++;
+
+		short unsigned int cell = choose(), mask = Candidates[cell];
+		Culprits blamed = nobody();
+
+		// The values already removed are ruled out by their own reasons
+		for(short unsigned int v = 0; v < 9; v++)
+			if(!(mask & (1 << v)))
+				blame(blamed, Reasons[cell][v]);
+
+		SUDOKU_TRACE_EVENT("branch", cell);
+		for(; mask; mask &= mask - 1) {
+			short unsigned int myP = __builtin_ctz(mask) + 1;
+			size_t mark = Trail.size();
+			Culprits failure;
+
+			Decisions[level] = cell * 9 + myP - 1;
+			if(assign(cell, myP, only(level), failure) && descend(level + 1, failure))
+				return true;
+
+			undo(mark);
+			if(Stopped)
+				return false;
+
+			if(!guilty(failure, level)) {
+				Jumps++;
+				conflict = failure;
+				return false;
+			}
+
+			failure.Bits[level >> 6] &= ~(1ULL << (level & 63));
+			learn(cell * 9 + myP - 1, failure);
+			blame(blamed, failure);
+		}
+
+		conflict = blamed;
+		return false;
+	}
+
+	/**
+	 * Searches a solution of the loaded grid.
+	 * \arg		budget	limits of the search, spending a node per decision
+	 * \return	true if a solution was found; if not, budget.exceeded() tells whether the grid has
+	 *			no solution or the search was stopped
+	 */
+	bool Backjumper::solve(Budget& budget) {
+		SUDOKU_TRACE_SPAN("backjump");
+		Culprits conflict;
+
+		Limits = &budget;
+		return descend(1, conflict);
+	}
+
+	/**
+	 * Returns the value of a cell, or 0 if it's undecided.
+	 */
+	short unsigned int Backjumper::get(short unsigned int cell) const {
+		return Values[cell];
+	}
+
+	/**
+	 * Returns the number of decisions taken.
+	 */
+	unsigned long Backjumper::getNodes() const {
+		return Nodes;
+	}
+
+	/**
+	 * Returns the number of decision levels jumped over.
+	 */
+	unsigned long Backjumper::getJumps() const {
+		return Jumps;
+	}
+
+	/**
+	 * Returns the number of nogoods learnt.
+	 */
+	size_t Backjumper::getNogoods() const {
+		return Nogoods.size();
+	}
+
+	/**
+	 * Solves a grid.
+	 * \arg		grid	state to solve; on success it's replaced by the solution
+	 * \return	true if the grid has a solution
+	 */
+	bool Backjumper::solve(Grid& grid) {
+		Budget unlimited;
+
+		return solve(grid, unlimited);
+	}
+
+	/**
+	 * Solves a grid within a budget.
+	 * \arg		grid	state to solve; on success it's replaced by the solution
+	 * \arg		budget	limits of the search, spending a node per decision
+	 * \return	true if a solution was found; if not, budget.exceeded() tells whether the grid has
+	 *			no solution or the search was stopped
+	 */
+	bool Backjumper::solve(Grid& grid, Budget& budget) {
+		Backjumper* engine = new Backjumper();
+		bool solved = engine->load(grid) && engine->solve(budget);
+
+		for(short unsigned int c = 0; c < 81 && solved; c++)
+			grid.assign(c, engine->get(c));
+
+		delete engine;
+		return solved;
+	}
+
+	/**
+	 * Solves a sudoku board within a budget, which is left with the solution if one was found.
+	 * \arg		Sudoku	board to solve
+	 * \arg		budget	limits of the search, spending a node per decision
+	 * \return	true if a solution was found
+	 */
+	bool Backjumper::solve(Board& Sudoku, Budget& budget) {
+		Grid grid;
+
+		if(!grid.load(Sudoku) || !solve(grid, budget))
+			return false;
+
+		grid.store(Sudoku);
+		return true;
+	}
+}
+}
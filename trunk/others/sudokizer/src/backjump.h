@@ -0,0 +1,77 @@
+// See COPYING file for licensing information.
+/**
+ * \file backjump.h
+ * Definition of the search with conflict-directed backjumping and nogood learning.
+ */
+
+#ifndef BACKJUMP_H
+#define BACKJUMP_H
+
+#include "sudoku.h"
+#include "search.h"
+#include "budget.h"
+#include <vector>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Set of decision levels, in the range [1,127], blamed for a removed candidate or a conflict.
+	 */
+	typedef struct {
+		unsigned long long Bits[2];
+	} Culprits;
+
+	/**
+	 * Depth-first search which knows why each candidate was removed.
+	 * Every removal keeps the decision levels it follows from; when a cell is left without
+	 * candidates, or a value without a place in a unit (the cases where Cell::fastDelPossibility
+	 * throws), the levels of the removals involved are the conflict. If the decision being tried
+	 * isn't among them, the search jumps straight back to the latest one which is, instead of
+	 * trying the other values of every decision in between. Each value failed that way also gives a
+	 * nogood, the decisions which rule it out, kept till the end of the search to rule it out again
+	 * wherever these decisions come together.
+	 * The state is undone from a trail instead of being copied in every branch.
+	 */
+	class Backjumper {
+		short unsigned int Candidates[81];
+		short unsigned int Values[81];
+		short unsigned int Unsolved;
+		Culprits Reasons[81][9];			// levels which removed each candidate
+		Culprits Why[81];					// levels which set the value of each cell
+		vector<short unsigned int> Trail;	// removals, and values set (729 + cell)
+		short unsigned int Decisions[128];	// cell * 9 + value - 1 of each level
+		vector< vector<short unsigned int> > Nogoods;
+		vector<unsigned int> Watches[729];	// nogoods holding each cell * 9 + value - 1
+		Budget* Limits;
+		bool Stopped;
+		unsigned long Nodes, Jumps;
+
+		Backjumper(const Backjumper& copy);
+
+		bool assign(short unsigned int cell, short unsigned int myP, const Culprits& why, Culprits& conflict);
+		bool exclude(short unsigned int cell, short unsigned int myP, const Culprits& why, Culprits& conflict);
+		bool check(short unsigned int literal, Culprits& conflict);
+		void learn(short unsigned int literal, const Culprits& culprits);
+		void undo(size_t mark);
+		short unsigned int choose() const;
+		bool descend(short unsigned int level, Culprits& conflict);
+	public:
+		static const size_t MaxNogoods = 4096;
+		static const size_t MaxNogoodSize = 12;
+
+		Backjumper();
+
+		bool load(const Grid& grid);
+		bool solve(Budget& budget);
+		short unsigned int get(short unsigned int cell) const;
+		unsigned long getNodes() const;
+		unsigned long getJumps() const;
+		size_t getNogoods() const;
+
+		static bool solve(Grid& grid);
+		static bool solve(Grid& grid, Budget& budget);
+		static bool solve(Board& Sudoku, Budget& budget);
+	};
+}
+}
+#endif
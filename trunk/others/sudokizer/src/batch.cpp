@@ -0,0 +1,214 @@
+// See COPYING file for licensing information.
+/**
+ * \file batch.cpp
+ * Implementation of the solving of many puzzles at once, one per SIMD lane.
+ * The vector operations are the ones of lanes.h, so that the propagation is written once for
+ * AVX2, SSE2 and plain code.
+ */
+#include "batch.h"
+#include "tables.h"
+#include "trace.h"
+#include <cstring>
+
+namespace std {
+namespace sudoku {
+	const short unsigned int Batch::Width;
+
+	/**
+	 * Loads up to Width puzzles in the lanes. The lanes left over get a copy of the first puzzle.
+	 * \arg		puzzles	lines of 81 characters and a new line; '1' to '9' are the givens
+	 * \arg		count	number of puzzles, in [1,Width]
+	 */
+	void Batch::load(const char* puzzles, size_t count) {
+		short unsigned int lanes[SUDOKU_LANES];
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			for(short unsigned int l = 0; l < Width; l++) {
+				char given = puzzles[(l < count ? l : 0) * 82 + c];
+
+				lanes[l] = (given >= '1' && given <= '9') ? 1 << (given - '1') : 0x1FF;
+			}
+
+			Cells[c] = pack(lanes);
+			Propagated[c] = splat(0);
+		}
+	}
+
+	/**
+	 * Removes the value of every cell left with a single candidate from its peers, in the lanes
+	 * where it wasn't removed yet.
+	 * \return	true if anything changed
+	 */
+	bool Batch::nakedSingles() {
+		bool changed = false;
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			Lanes cell = Cells[c],
+				single = butNot(isZero(both(cell, decrement(cell))), isZero(cell)),
+				fresh = butNot(single, Propagated[c]);
+
+			if(!any(fresh))
+				continue;
+
+			Lanes value = both(cell, fresh);
+
+			for(short unsigned int i = 0; i < 20; i++)
+				Cells[Peers[c][i]] = butNot(Cells[Peers[c][i]], value);
+
+			Propagated[c] = either(Propagated[c], fresh);
+			changed = true;
+		}
+
+		return changed;
+	}
+
+	/**
+	 * Makes every value possible in a single cell of a unit the only candidate of that cell.
+	 * \return	true if anything changed
+	 */
+	bool Batch::hiddenSingles() {
+		bool changed = false;
+
+		for(short unsigned int u = 0; u < 27; u++) {
+			Lanes once = splat(0), twice = splat(0);
+
+			for(short unsigned int i = 0; i < 9; i++) {
+				twice = either(twice, both(once, Cells[UnitCells[u][i]]));
+				once = either(once, Cells[UnitCells[u][i]]);
+			}
+
+			Lanes singles = butNot(once, twice);
+
+			if(!any(singles))
+				continue;
+
+			for(short unsigned int i = 0; i < 9; i++) {
+				Lanes cell = Cells[UnitCells[u][i]], hit = both(cell, singles), keep = isZero(hit),
+					result = either(both(keep, cell), butNot(hit, keep));
+
+				if(!same(result, cell)) {
+					Cells[UnitCells[u][i]] = result;
+					changed = true;
+				}
+			}
+		}
+
+		return changed;
+	}
+
+	/**
+	 * Propagates naked singles, and hidden singles when there are no more naked ones, till
+	 * nothing changes in any lane.
+	 */
+	void Batch::propagate() {
+		SUDOKU_TRACE_SPAN("batch propagation");
+
+		while(nakedSingles() || hiddenSingles())
+			;
+	}
+
+	/**
+	 * Returns the candidates bitmask of a cell in a lane.
+	 */
+	short unsigned int Batch::get(short unsigned int cell, short unsigned int lane) const {
+		short unsigned int lanes[SUDOKU_LANES];
+
+		unpack(Cells[cell], lanes);
+		return lanes[lane];
+	}
+
+	/**
+	 * Writes the solution of the puzzle of a lane, searching for it if the singles didn't solve it.
+	 * \arg		lane	the lane
+	 * \arg		out		where the 81 digits are written
+	 * \arg		budget	limits of the search
+	 * \return	false if the puzzle has no solution or the budget was exceeded, in which case
+	 *			nothing is written
+	 */
+	bool Batch::finish(short unsigned int lane, char* out, Budget& budget) const {
+		short unsigned int masks[81];
+		bool solved = true;
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			masks[c] = get(c, lane);
+			if(masks[c] == 0)
+				return false;
+			solved = solved && (masks[c] & (masks[c] - 1)) == 0;
+		}
+
+		if(solved) {
+			for(short unsigned int c = 0; c < 81; c++)
+				out[c] = '1' + __builtin_ctz(masks[c]);
+			return true;
+		}
+
+		Grid grid;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			for(short unsigned int p = 1; p < 10; p++)
+				if(!(masks[c] & (1 << (p - 1))) && !grid.eliminate(c, p))
+					return false;
+
+		if(!Search::solve(grid, budget))
+			return false;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			out[c] = '0' + grid.get(c);
+		return true;
+	}
+
+	/**
+	 * Solves a set of puzzles, Width at a time.
+	 * \arg		puzzles	lines of 81 characters and a new line, as Render writes them in the oneline
+	 *					format: '1' to '9' for the givens and anything else for the empty cells
+	 * \arg		count	number of puzzles
+	 * \arg		out		where the solutions are written, in the same format; the puzzles without
+	 *					solution are copied as they are
+	 * \return	number of puzzles solved
+	 */
+	size_t Batch::solve(const char* puzzles, size_t count, char* out) {
+		Budget unlimited;
+
+		return solve(puzzles, count, out, unlimited);
+	}
+
+	/**
+	 * Solves a set of puzzles within a budget, Width at a time. The clock and the cancel flag are
+	 * read before each set of Width puzzles; once the budget is exceeded, the puzzles left are
+	 * copied as if they had no solution.
+	 * \arg		puzzles	lines of 81 characters and a new line, as for the solving without budget
+	 * \arg		count	number of puzzles
+	 * \arg		out		where the solutions are written, in the same format; the puzzles without
+	 *					solution are copied as they are
+	 * \arg		budget	limits of the searches finishing the puzzles the lanes don't solve, which
+	 *					spend a node per branch
+	 * \return	number of puzzles solved; if budget.exceeded(), some of the others may have a
+	 *			solution
+	 */
+	size_t Batch::solve(const char* puzzles, size_t count, char* out, Budget& budget) {
+		size_t solved = 0;
+
+		for(size_t first = 0; first < count; first += Width) {
+			size_t n = count - first < Width ? count - first : Width;
+			bool within = budget.poll();
+
+			if(within) {
+				load(puzzles + first * 82, n);
+				propagate();
+			}
+
+			for(short unsigned int l = 0; l < n; l++) {
+				char* line = out + (first + l) * 82;
+
+				if(within && finish(l, line, budget))
+					solved++;
+				else
+					memcpy(line, puzzles + (first + l) * 82, 81);
+				line[81] = '\n';
+			}
+		}
+
+		return solved;
+	}
+}
+}
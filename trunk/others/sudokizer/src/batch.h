@@ -0,0 +1,41 @@
+// See COPYING file for licensing information.
+/**
+ * \file batch.h
+ * Definition of the solving of many puzzles at once, one per SIMD lane.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "sudoku.h"
+#include "search.h"
+#include "lanes.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Solver of batches of puzzles, for bulk workloads of easy ones.
+	 * The candidates of SUDOKU_LANES boards are kept cell by cell (Cells[c] holds cell c of every
+	 * board), so that naked and hidden singles are propagated on all of them in lockstep, with one
+	 * vector instruction doing the work of a board per lane. The boards which singles alone can't
+	 * solve are finished by the backtracking Search, starting from what the lanes found.
+	 */
+	class Batch {
+		Lanes Cells[81];
+		Lanes Propagated[81];
+
+		void load(const char* puzzles, size_t count);
+		void propagate();
+		bool nakedSingles();
+		bool hiddenSingles();
+		short unsigned int get(short unsigned int cell, short unsigned int lane) const;
+		bool finish(short unsigned int lane, char* out, Budget& budget) const;
+	public:
+		static const short unsigned int Width = SUDOKU_LANES;
+
+		size_t solve(const char* puzzles, size_t count, char* out);
+		size_t solve(const char* puzzles, size_t count, char* out, Budget& budget);
+	};
+}
+}
+#endif
@@ -0,0 +1,324 @@
+// See COPYING file for licensing information.
+/**
+ * \file benchmark.cpp
+ * Benchmark of the solver engines over a corpus of puzzles.
+ * Every puzzle of the file is solved by each engine asked for, the solutions are checked, and the
+ * puzzles per second and the nodes spent are printed, one engine per line. The choice of the
+ * branching cell can also be timed against the linear scan of the cells it replaces.
+ */
+
+#include "search.h"
+#include "sat.h"
+#include "backjump.h"
+#include "portfolio.h"
+#include "parser.h"
+#include "validator.h"
+#include "trace.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace sudoku;
+
+/**
+ * Returns the time of a monotonic clock in seconds.
+ */
+static double now() {
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Reads a whole file into memory.
+ * \arg		path	the file, or "-" for the standard input
+ * \arg		text	set to the contents of the file
+ * \return	false if it couldn't be read
+ */
+static bool slurp(const char* path, vector<char>& text) {
+	int fd = strcmp(path, "-") == 0 ? 0 : open(path, O_RDONLY);
+	char buffer[65536];
+	ssize_t got;
+
+	if(fd < 0)
+		return false;
+
+	text.clear();
+	while((got = read(fd, buffer, sizeof(buffer))) != 0) {
+		if(got < 0 && errno == EINTR)
+			continue;
+		if(got < 0)
+			break;
+		text.insert(text.end(), buffer, buffer + got);
+	}
+
+	if(fd != 0)
+		close(fd);
+	return got == 0;
+}
+
+/**
+ * Solves a puzzle with an engine.
+ * \arg		engine	name of the engine
+ * \arg		values	the 81 cells, 0 for the empty ones
+ * \arg		solution	set to the solution as 81 digits
+ * \arg		nodes	increased by the nodes spent
+ * \return	false if no solution was found
+ */
+static bool solve(const char* engine, const short unsigned int* values, char* solution, unsigned long& nodes) {
+	Grid grid;
+	Budget budget;
+	bool solved = true;
+
+	for(short unsigned int c = 0; c < 81 && solved; c++)
+		if(values[c] != 0)
+			solved = grid.assign(c, values[c]);
+
+	if(solved && strcmp(engine, "search") == 0)
+		solved = Search::solve(grid, budget);
+	else if(solved && strcmp(engine, "backjump") == 0)
+		solved = Backjumper::solve(grid, budget);
+	else if(solved && strcmp(engine, "sat") == 0) {
+		Board Sudoku;
+
+		grid.store(Sudoku);
+		solved = SatSolver::solve(Sudoku, budget) && grid.load(Sudoku);
+	} else if(solved) {
+		Board Sudoku;
+		Portfolio portfolio;
+
+		grid.store(Sudoku);
+		solved = portfolio.solve(Sudoku, budget) && grid.load(Sudoku);
+	}
+
+	nodes += budget.getNodes();
+	for(short unsigned int c = 0; c < 81; c++)
+		solution[c] = '0' + grid.get(c);
+
+	return solved && grid.isSolved();
+}
+
+/**
+ * Chooses the cell with the fewest candidates by looking at every cell, as the search did before
+ * it kept the cells by number of candidates.
+ */
+static short unsigned int scan(const short unsigned int* values, const short unsigned int* candidates) {
+	short unsigned int best = 81, fewest = 10;
+
+	for(short unsigned int c = 0; c < 81; c++) {
+		if(values[c] == 0) {
+			short unsigned int n = __builtin_popcount(candidates[c]);
+
+			if(n < fewest) {
+				fewest = n;
+				best = c;
+
+				if(n == 2)
+					break;
+			}
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Times the choice of the branching cell over the states met along the first branches of the
+ * search of each puzzle, with Grid::choose and with a scan of every cell.
+ * \arg		puzzles	the 81 cells of each puzzle
+ * \arg		rounds	number of times each state is timed
+ */
+static void selection(const vector<short unsigned int>& puzzles, unsigned long rounds) {
+	vector<Grid> grids;
+	vector<short unsigned int> values, candidates;
+
+	for(size_t p = 0; p < puzzles.size(); p += 81) {
+		Grid grid;
+		bool valid = true;
+
+		for(short unsigned int c = 0; c < 81 && valid; c++)
+			if(puzzles[p + c] != 0)
+				valid = grid.assign(c, puzzles[p + c]);
+
+		// Down the first branch till a contradiction or a solution
+		while(valid && !grid.isSolved()) {
+			grids.push_back(grid);
+			for(short unsigned int c = 0; c < 81; c++) {
+				values.push_back(grid.get(c));
+				candidates.push_back(grid.getCandidates(c));
+			}
+
+			short unsigned int cell = grid.choose();
+
+			valid = grid.assign(cell, __builtin_ctz(grid.getCandidates(cell)) + 1);
+		}
+	}
+
+	if(grids.empty())
+		return;
+
+	// The choices go to a volatile so that the compiler keeps the loops
+	volatile short unsigned int chosen;
+	unsigned long agree = 0;
+	double start = now();
+
+	for(unsigned long r = 0; r < rounds; r++)
+		for(size_t g = 0; g < grids.size(); g++)
+			chosen = grids[g].choose();
+
+	double buckets = now() - start;
+
+	start = now();
+	for(unsigned long r = 0; r < rounds; r++)
+		for(size_t g = 0; g < grids.size(); g++)
+			chosen = scan(&values[g * 81], &candidates[g * 81]);
+
+	double linear = now() - start;
+
+	(void) chosen;
+
+	for(size_t g = 0; g < grids.size(); g++)
+		agree += grids[g].choose() == scan(&values[g * 81], &candidates[g * 81]);
+
+	cout << "choose   " << grids.size() << " states  buckets " << fixed << setprecision(1)
+		<< buckets * 1e9 / (rounds * grids.size()) << " ns  scan " << linear * 1e9 / (rounds * grids.size())
+		<< " ns  same cell " << agree << "/" << grids.size() << endl;
+}
+
+/**
+ * Prints the usage.
+ */
+static int usage(const char* name) {
+	cerr << "usage: " << name << " [-e search|sat|backjump|portfolio|all] [-r rounds] [-s] [-t trace] file" << endl
+		<< "  file        puzzles in any format the command line reads, - for the standard input" << endl
+		<< "  -e engine   engine to time, or all of them one after the other (default: search)" << endl
+		<< "  -r rounds   times every puzzle is solved (default: 1)" << endl
+		<< "  -s          also time the choice of the branching cell against a scan of the cells" << endl
+		<< "  -t trace    write the timeline of the solver phases to this Chrome trace file; only" << endl
+		<< "              builds made with scons trace=1 record it" << endl;
+	return 2;
+}
+
+/**
+ * Benchmark entry point.
+ * \return	0 if every puzzle was solved by every engine, 1 if not, 2 for a usage error
+ */
+int main(int argc, char** argv) {
+	static const char* engines[] = {"search", "backjump", "sat", "portfolio"};
+	const char* engine = "search";
+	const char* trace = 0;
+	unsigned long rounds = 1;
+	bool choosing = false;
+	int option;
+
+	while((option = getopt(argc, argv, "e:r:st:")) != -1) {
+		switch(option) {
+			case 'e':
+				engine = optarg;
+				break;
+			case 'r':
+				rounds = strtoul(optarg, 0, 10);
+				break;
+			case 's':
+				choosing = true;
+				break;
+			case 't':
+				trace = optarg;
+				break;
+			default:
+				return usage(argv[0]);
+		}
+	}
+
+	if(optind != argc - 1 || rounds == 0)
+		return usage(argv[0]);
+
+	bool every = strcmp(engine, "all") == 0, known = every;
+
+	for(short unsigned int e = 0; e < 4; e++)
+		known = known || strcmp(engine, engines[e]) == 0;
+	if(!known)
+		return usage(argv[0]);
+
+	if(trace && !Trace::enabled()) {
+		cerr << argv[0] << ": this build doesn't record the timeline, build it with scons trace=1" << endl;
+		return 2;
+	}
+
+	vector<char> text;
+	vector<short unsigned int> puzzles;
+	short unsigned int values[81];
+
+	if(!slurp(argv[optind], text)) {
+		cerr << argv[0] << ": can't read " << argv[optind] << endl;
+		return 2;
+	}
+
+	Parser parser(text.empty() ? "" : &text[0], text.size());
+
+	while(parser.next(values))
+		puzzles.insert(puzzles.end(), values, values + 81);
+
+	size_t count = puzzles.size() / 81;
+
+	if(count == 0) {
+		cerr << argv[0] << ": no puzzle found in " << argv[optind] << endl;
+		return 2;
+	}
+
+	vector<char> solutions(count * 81);
+	int status = 0;
+
+	for(short unsigned int e = 0; e < 4; e++) {
+		if(!every && strcmp(engine, engines[e]) != 0)
+			continue;
+
+		unsigned long nodes = 0, failed = 0;
+		double start = now();
+
+		for(unsigned long r = 0; r < rounds; r++)
+			for(size_t p = 0; p < count; p++)
+				if(!solve(engines[e], &puzzles[p * 81], &solutions[p * 81], nodes))
+					failed++;
+
+		double seconds = now() - start;
+		bool* checked = new bool[count];
+		size_t correct = Validator::check(&solutions[0], count, checked, 81);
+
+		// A solution has to keep the givens of its puzzle
+		for(size_t p = 0; p < count; p++)
+			for(short unsigned int c = 0; c < 81 && checked[p]; c++)
+				if(puzzles[p * 81 + c] != 0 && solutions[p * 81 + c] != '0' + puzzles[p * 81 + c]) {
+					checked[p] = false;
+					correct--;
+				}
+		delete[] checked;
+
+		cout << setw(10) << left << engines[e] << right << count * rounds << " puzzles  " << fixed << setprecision(3)
+			<< seconds << " s  " << setprecision(0) << count * rounds / seconds << " puzzles/s  "
+			<< nodes / rounds << " nodes" << endl;
+
+		if(failed > 0 || correct != count) {
+			cerr << engines[e] << ": " << failed << " unsolved, " << count - correct << " wrong" << endl;
+			status = 1;
+		}
+	}
+
+	if(choosing)
+		selection(puzzles, 1000);
+
+	if(trace && !Trace::save(trace)) {
+		cerr << argv[0] << ": can't write " << trace << endl;
+		return 2;
+	}
+
+	return status;
+}
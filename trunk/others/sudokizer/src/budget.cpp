@@ -0,0 +1,104 @@
+// See COPYING file for licensing information.
+/**
+ * \file budget.cpp
+ * Implementation of the time and node limits of the solving and generating calls.
+ */
+#include "budget.h"
+#include <sys/time.h>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Returns the current time in seconds.
+	 */
+	static double now() {
+		timeval tv;
+
+		gettimeofday(&tv, 0);
+		return tv.tv_sec + tv.tv_usec / 1e6;
+	}
+
+	/**
+	 * Budget constructor.
+	 * \arg		seconds	time allowed from now on, or 0 for no deadline
+	 * \arg		nodes	nodes allowed, or 0 for no limit
+	 * \arg		cancel	flag which cancels the call once it's set to a non zero value, or 0 to
+	 *					only cancel it through cancel()
+	 */
+	Budget::Budget(double seconds, unsigned long nodes, volatile int* cancel)
+		: Deadline(seconds > 0 ? now() + seconds : 0), Limit(nodes), Nodes(0), Next(0),
+		  Status(withinBudget), Flag(0), Cancel(cancel != 0 ? cancel : &Flag)
+	{
+		check(0);
+	}
+
+	/**
+	 * Reads the cancel flag and the clock, and decides when they'll be read next.
+	 * Threads sharing the budget may get here at once: only the one which moves the next check on
+	 * reads them, the others go on with the status as it is. The status only leaves withinBudget
+	 * once, so the first reason found to stop is the one kept.
+	 * \arg		nodes	the nodes spent, as the caller counted them
+	 * \return	false if the budget is exceeded
+	 */
+	bool Budget::check(unsigned long nodes) {
+		unsigned long next = Next, following = nodes + Interval;
+
+		if(Limit != 0 && following > Limit + 1)
+			following = Limit + 1;
+
+		if(__sync_bool_compare_and_swap(&Next, next, following)) {
+			tBudget status = withinBudget;
+
+			if(*Cancel)
+				status = cancelled;
+			else if(Limit != 0 && nodes > Limit)
+				status = outOfNodes;
+			else if(Deadline != 0 && now() >= Deadline)
+				status = outOfTime;
+
+			if(status != withinBudget)
+				__sync_bool_compare_and_swap(&Status, withinBudget, status);
+		}
+
+		return Status == withinBudget;
+	}
+
+	/**
+	 * Reads the cancel flag and the clock without spending a node. Used by a thread waiting for
+	 * others instead of running an engine itself.
+	 * \return	false if the budget is exceeded
+	 */
+	bool Budget::poll() {
+		return check(__sync_add_and_fetch(&Nodes, 0));
+	}
+
+	/**
+	 * Cancels the call using the budget. It can be called from any thread; the call notices it
+	 * within Interval nodes.
+	 */
+	void Budget::cancel() {
+		*Cancel = 1;
+	}
+
+	/**
+	 * States if the budget is exceeded.
+	 */
+	bool Budget::exceeded() const {
+		return Status != withinBudget;
+	}
+
+	/**
+	 * Returns the state of the budget.
+	 */
+	tBudget Budget::getStatus() const {
+		return Status;
+	}
+
+	/**
+	 * Returns the number of nodes spent so far.
+	 */
+	unsigned long Budget::getNodes() const {
+		return Nodes;
+	}
+}
+}
@@ -0,0 +1,77 @@
+// See COPYING file for licensing information.
+/**
+ * \file budget.h
+ * Definition of the time and node limits of the solving and generating calls.
+ */
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+namespace std {
+namespace sudoku {
+	/**
+	 * State of a budget:
+	 * - withinBudget: the call may go on
+	 * - outOfTime: the deadline was reached
+	 * - outOfNodes: the allowed number of nodes was spent
+	 * - cancelled: the cancel flag was set from outside
+	 */
+	typedef enum{withinBudget,outOfTime,outOfNodes,cancelled} tBudget;
+
+	/**
+	 * Limits of a solving, counting or generating call: a deadline, a number of nodes (search
+	 * branches, propagation passes, conflicts or generation attempts, depending on the engine) and
+	 * a cancel flag which any other thread may set.
+	 * The engines spend one node at a time; the clock and the flag are only read every Interval
+	 * nodes, so spending is an increment and a comparison. Once exceeded a budget stays so, and the
+	 * call using it returns as soon as it sees it; its status tells why.
+	 */
+	class Budget {
+		double Deadline;
+		unsigned long Limit;
+		unsigned long Nodes;
+		volatile unsigned long Next;
+		volatile tBudget Status;
+		volatile int Flag;
+		volatile int* Cancel;
+
+		static const unsigned long Interval = 1024;
+
+		Budget(const Budget& copy);
+
+		bool check(unsigned long nodes);
+	public:
+		Budget(double seconds = 0, unsigned long nodes = 0, volatile int* cancel = 0);
+
+		/**
+		 * Spends a node. Used by the engines running on a single thread.
+		 * \return	false if the budget is exceeded
+		 */
+		bool spend() {
+			if(++Nodes >= Next)
+				return check(Nodes);
+			return Status == withinBudget;
+		}
+
+		/**
+		 * Spends a node from any of the threads sharing the budget. Of the threads reaching the
+		 * next check at once, only one makes it.
+		 * \return	false if the budget is exceeded
+		 */
+		bool share() {
+			unsigned long nodes = __sync_add_and_fetch(&Nodes, 1);
+
+			if(nodes >= Next)
+				return check(nodes);
+			return Status == withinBudget;
+		}
+
+		bool poll();
+		void cancel();
+		bool exceeded() const;
+		tBudget getStatus() const;
+		unsigned long getNodes() const;
+	};
+}
+}
+#endif
@@ -0,0 +1,238 @@
+// See COPYING file for licensing information.
+/**
+ * \file carver.cpp
+ * Implementation of the generation of puzzles within a band of difficulty.
+ */
+#include "carver.h"
+#include "tables.h"
+#include "trace.h"
+#include <cstdlib>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Carver constructor.
+	 * \arg		table	table shared by the searches for a second solution, or 0 for none
+	 */
+	Carver::Carver(TranspositionTable* table)
+		: Grade(noHint), Table(table), Gradings(0), Shortcuts(0)
+	{
+		for(short unsigned int c = 0; c < 81; c++) {
+			Values[c] = 0;
+			Solution[c] = 0;
+		}
+	}
+
+	/**
+	 * Removes a clue, which the peers of its cell don't see anymore.
+	 * \arg		c	index of a cell holding a clue
+	 */
+	void Carver::take(short unsigned int c) {
+		short unsigned int v = Values[c] - 1;
+
+		Values[c] = 0;
+		for(short unsigned int i = 0; i < 20; i++)
+			Covers[Peers[c][i]][v]--;
+	}
+
+	/**
+	 * Puts a clue back.
+	 * \arg		c		index of an empty cell
+	 * \arg		value	the clue, in the range [1,9]
+	 */
+	void Carver::put(short unsigned int c, short unsigned int value) {
+		Values[c] = value;
+		for(short unsigned int i = 0; i < 20; i++)
+			Covers[Peers[c][i]][value - 1]++;
+	}
+
+	/**
+	 * Tells whether an empty cell is forced by the clues alone.
+	 * \arg		c	index of an empty cell
+	 * \return	nakedSingle if its value is the only one its peers don't hold, hiddenSingle if no other
+	 *			empty cell of one of its units can take its value, or noHint
+	 */
+	tTechnique Carver::single(short unsigned int c) const {
+		short unsigned int v = Solution[c] - 1, candidates = 0;
+
+		for(short unsigned int p = 0; p < 9; p++)
+			candidates += Covers[c][p] == 0;
+		if(candidates == 1)
+			return nakedSingle;
+
+		for(short unsigned int u = 0; u < 3; u++) {
+			bool hidden = true;
+
+			for(short unsigned int i = 0; i < 8 && hidden; i++) {
+				short unsigned int other = UnitPeers[c][u][i];
+
+				hidden = Values[other] != 0 || Covers[other][v] != 0;
+			}
+
+			if(hidden)
+				return hiddenSingle;
+		}
+
+		return noHint;
+	}
+
+	/**
+	 * Tells whether the clues have a single solution, with a search for a second one.
+	 */
+	bool Carver::unique() const {
+		Grid grid;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(Values[c] != 0 && !grid.assign(c, Values[c]))
+				return false;
+
+		return (Table ? Search::count(grid, *Table, 2) : Search::count(grid, 2)) == 1;
+	}
+
+	/**
+	 * Builds a random solution: a few random givens which still have a solution make it random.
+	 * \arg		seed	state of the random numbers
+	 * \return	false if the search failed
+	 */
+	bool Carver::fill(unsigned int& seed) {
+		Grid grid;
+
+		for(short unsigned int i = 0; i < 11; i++) {
+			Grid next = grid;
+
+			if(next.assign(rand_r(&seed) % 81, rand_r(&seed) % 9 + 1)
+				&& (Table ? Search::count(next, *Table, 1) : Search::count(next, 1)) != 0)
+				grid = next;
+		}
+
+		if(!(Table ? Search::solve(grid, *Table) : Search::solve(grid)))
+			return false;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			Solution[c] = grid.get(c);
+
+		return true;
+	}
+
+	/**
+	 * Digs a puzzle out of a solution, as hard as it can be without going past a technique.
+	 * \arg		solution	the 81 values of the solution
+	 * \arg		highest		hardest technique the puzzle may need, noHint for no limit
+	 * \arg		seed		state of the random numbers, which give the order of the clues
+	 * \return	the grade of the puzzle dug
+	 */
+	tTechnique Carver::carve(const short unsigned int* solution, tTechnique highest, unsigned int& seed) {
+		SUDOKU_TRACE_SPAN("carve");
+		short unsigned int order[81];
+		tTechnique ceiling = highest == noHint ? xWing : highest;
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			Solution[c] = solution[c];
+			Values[c] = solution[c];
+			order[c] = c;
+			for(short unsigned int p = 0; p < 9; p++)
+				Covers[c][p] = 0;
+		}
+
+		for(short unsigned int c = 0; c < 81; c++)
+			for(short unsigned int i = 0; i < 20; i++)
+				Covers[Peers[c][i]][Values[c] - 1]++;
+
+		for(short unsigned int c = 80; c > 0; c--) {
+			short unsigned int other = rand_r(&seed) % (c + 1), swap = order[c];
+
+			order[c] = order[other];
+			order[other] = swap;
+		}
+
+		Grade = nakedSingle;
+
+		for(short unsigned int i = 0; i < 81; i++) {
+			short unsigned int c = order[i], value = Values[c];
+			tTechnique forced, grade;
+
+			take(c);
+
+			// Found back by a single, the clue changes neither the grade nor the solutions
+			forced = single(c);
+			if(forced == nakedSingle || (forced == hiddenSingle && Grade >= hiddenSingle)) {
+				Shortcuts++;
+				continue;
+			}
+
+			// Fewer clues never make a puzzle easier, so past the techniques it stays past them
+			Gradings++;
+			grade = Grade == noHint ? noHint : Grader.grade(Values, ceiling);
+
+			if(grade != noHint)
+				Grade = grade;
+			else if(highest == noHint && unique())
+				Grade = noHint;
+			else
+				put(c, value);
+		}
+
+		return Grade;
+	}
+
+	/**
+	 * Generates a puzzle whose grade is within a band.
+	 * \arg		lowest	easiest technique the puzzle must need, noHint for the puzzles none solves
+	 * \arg		highest	hardest technique the puzzle may need, noHint for no limit
+	 * \arg		seed	state of the random numbers
+	 * \arg		budget	limits of the generation; a node is a solution dug
+	 * \return	false if the budget ran out first
+	 */
+	bool Carver::generate(tTechnique lowest, tTechnique highest, unsigned int& seed, Budget& budget) {
+		short unsigned int solution[81];
+
+		while(budget.spend()) {
+			if(!fill(seed))
+				continue;
+
+			for(short unsigned int c = 0; c < 81; c++)
+				solution[c] = Solution[c];
+
+			if(carve(solution, highest, seed) >= lowest)
+				return true;
+		}
+
+		return false;
+	}
+
+	/**
+	 * Returns the clues of the last puzzle dug, 0 for the empty cells.
+	 */
+	const short unsigned int* Carver::getPuzzle() const {
+		return Values;
+	}
+
+	/**
+	 * Returns the solution of the last puzzle dug.
+	 */
+	const short unsigned int* Carver::getSolution() const {
+		return Solution;
+	}
+
+	/**
+	 * Returns the grade of the last puzzle dug.
+	 */
+	tTechnique Carver::getGrade() const {
+		return Grade;
+	}
+
+	/**
+	 * Returns the number of removals which needed the puzzle to be solved again.
+	 */
+	unsigned long Carver::getGradings() const {
+		return Gradings;
+	}
+
+	/**
+	 * Returns the number of removals taken without solving anything.
+	 */
+	unsigned long Carver::getShortcuts() const {
+		return Shortcuts;
+	}
+}
+}
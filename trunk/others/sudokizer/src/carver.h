@@ -0,0 +1,62 @@
+// See COPYING file for licensing information.
+/**
+ * \file carver.h
+ * Definition of the generation of puzzles within a band of difficulty.
+ */
+
+#ifndef CARVER_H
+#define CARVER_H
+
+#include "hint.h"
+#include "search.h"
+#include "budget.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Generator of puzzles whose grade, the hardest technique of the Hinter they need, is within a
+	 * band; noHint stands for the puzzles none of the techniques solves.
+	 * Clues are dug out of a random solution one at a time, in random order, and a removal which
+	 * takes the puzzle past the hardest technique of the band is undone at once. Only part of the
+	 * removals keep the grade without working it out again; the deductions of the Hinter aren't
+	 * kept, since a removal widens the candidates they started from:
+	 * - a removed clue still forced by a single among the other clues leaves the grade as it was,
+	 *   since the techniques find it back first; the counts of each value among the peers of every
+	 *   cell tell that without any solving. That is about two removals in five, see getShortcuts()
+	 * - the others, most of them, grade the puzzle from scratch with the techniques up to the
+	 *   ceiling of the band, which stops as soon as a harder one would be needed, see getGradings()
+	 * - only puzzles of the top band, which no technique solves, need a search for a second solution
+	 * A clue which can't go can't go later either, so every clue is tried once and the puzzle ends up
+	 * as hard as it can be below the ceiling. If that isn't enough for the band, another solution
+	 * is dug.
+	 */
+	class Carver {
+		short unsigned int Values[81];
+		short unsigned int Solution[81];
+		unsigned char Covers[81][9];
+		tTechnique Grade;
+		Hinter Grader;
+		TranspositionTable* Table;
+		unsigned long Gradings, Shortcuts;
+
+		Carver(const Carver& copy);
+
+		void take(short unsigned int c);
+		void put(short unsigned int c, short unsigned int value);
+		tTechnique single(short unsigned int c) const;
+		bool unique() const;
+		bool fill(unsigned int& seed);
+	public:
+		Carver(TranspositionTable* table = 0);
+
+		tTechnique carve(const short unsigned int* solution, tTechnique highest, unsigned int& seed);
+		bool generate(tTechnique lowest, tTechnique highest, unsigned int& seed, Budget& budget);
+		const short unsigned int* getPuzzle() const;
+		const short unsigned int* getSolution() const;
+		tTechnique getGrade() const;
+		unsigned long getGradings() const;
+		unsigned long getShortcuts() const;
+	};
+}
+}
+#endif
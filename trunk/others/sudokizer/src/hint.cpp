@@ -0,0 +1,496 @@
+// See COPYING file for licensing information.
+/**
+ * \file hint.cpp
+ * Implementation of the engine giving the next logical step of a game.
+ * Candidates are kept as bitmasks, bit v - 1 being set if v is still possible, and each technique
+ * is a scan of the units over them; the first step found stops the scan.
+ */
+#include "hint.h"
+#include "tables.h"
+#include "trace.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Returns the number of values set in a bitmask.
+	 */
+	static inline short unsigned int countBits(short unsigned int mask) {
+		return __builtin_popcount(mask);
+	}
+
+	/**
+	 * Returns the lowest value set in a non empty bitmask.
+	 */
+	static inline short unsigned int lowestValue(short unsigned int mask) {
+		return __builtin_ctz(mask) + 1;
+	}
+
+	/**
+	 * Starts a hint with the given technique and value, with no targets nor units yet.
+	 */
+	static inline void start(Hint& hint, tTechnique technique, bool place, short unsigned int value) {
+		hint.Technique = technique;
+		hint.Place = place;
+		hint.Value = value;
+		hint.TargetCount = 0;
+		hint.UnitCount = 0;
+	}
+
+	/**
+	 * Hinter constructor. It doesn't know any board yet.
+	 */
+	Hinter::Hinter()
+		: Source(0), Identity(0), Version(0), Moves(0)
+	{
+	}
+
+	/**
+	 * Rebuilds the candidates from the board: the possibilities listed in each undecided cell,
+	 * without the values placed among its peers.
+	 * \arg		Sudoku	board to read
+	 */
+	void Hinter::load(const Board& Sudoku) {
+		for(short unsigned int c = 0; c < 81; c++) {
+			const Cell& cell = *Sudoku.Cells[c];
+
+			Values[c] = (cell.State == definitive) ? cell.Possibilities[0] : 0;
+			Candidates[c] = 0;
+			for(short unsigned int i = 0; i < 9 && cell.Possibilities[i] != 0; i++)
+				Candidates[c] |= 1 << (cell.Possibilities[i] - 1);
+		}
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(Values[c] != 0) {
+				Candidates[c] = 1 << (Values[c] - 1);
+				for(short unsigned int i = 0; i < 20; i++)
+					if(Values[Peers[c][i]] == 0)
+						Candidates[Peers[c][i]] &= ~Candidates[c];
+			}
+	}
+
+	/**
+	 * Places a value in the cached candidates, removing it from the undecided peers.
+	 * \arg		c		index of an undecided cell
+	 * \arg		value	the value placed, in the range [1,9]
+	 */
+	void Hinter::apply(short unsigned int c, short unsigned int value) {
+		short unsigned int mask = 1 << (value - 1);
+
+		Values[c] = value;
+		Candidates[c] = mask;
+		for(short unsigned int i = 0; i < 20; i++)
+			if(Values[Peers[c][i]] == 0)
+				Candidates[Peers[c][i]] &= ~mask;
+	}
+
+	/**
+	 * Brings the cached candidates up to date with the board.
+	 * If the board is the one seen last time, it wasn't assigned or moved into since, and it has
+	 * only gained moves placing values in undecided cells since then, these moves are read from its
+	 * journal and applied; otherwise the candidates are rebuilt, forgetting the removals given as
+	 * hints.
+	 * \arg		Sudoku	board of the game
+	 */
+	void Hinter::sync(const Board& Sudoku) {
+		size_t moves = Sudoku.Journal.size();
+		bool replay = (Source == &Sudoku && Sudoku.Identity == Identity && moves >= Moves &&
+			Sudoku.Version - Version == moves - Moves);
+
+		for(size_t m = Moves; replay && m < moves; m++) {
+			const Move& move = Sudoku.Journal[m];
+
+			if(move.Before != 0 || move.After == 0)
+				replay = false;
+			else
+				apply(move.Index, move.After);
+		}
+
+		if(!replay)
+			load(Sudoku);
+
+		Source = &Sudoku;
+		Identity = Sudoku.Identity;
+		Version = Sudoku.Version;
+		Moves = moves;
+	}
+
+	/**
+	 * Looks for an undecided cell with a single candidate.
+	 */
+	bool Hinter::findNakedSingle(Hint& hint) const {
+		SUDOKU_TRACE_SPAN("naked single");
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(Values[c] == 0 && countBits(Candidates[c]) == 1) {
+				start(hint, nakedSingle, true, lowestValue(Candidates[c]));
+				hint.Targets[hint.TargetCount++] = c;
+				for(short unsigned int k = 0; k < 3; k++)
+					hint.Units[hint.UnitCount++] = CellUnits[c][k];
+				return true;
+			}
+
+		return false;
+	}
+
+	/**
+	 * Looks for a value fitting in a single cell of a unit. Boxes are looked at first, since the
+	 * players find the hidden singles in boxes more easily than in lines.
+	 */
+	bool Hinter::findHiddenSingle(Hint& hint) const {
+		SUDOKU_TRACE_SPAN("hidden single");
+
+		for(short unsigned int n = 0; n < 27; n++) {
+			short unsigned int u = (n + 18) % 27, once = 0, twice = 0, placed = 0;
+
+			for(short unsigned int i = 0; i < 9; i++) {
+				short unsigned int c = UnitCells[u][i];
+
+				if(Values[c] != 0)
+					placed |= Candidates[c];
+				else {
+					twice |= once & Candidates[c];
+					once |= Candidates[c];
+				}
+			}
+
+			short unsigned int singles = once & ~twice & ~placed;
+
+			if(singles != 0) {
+				short unsigned int value = lowestValue(singles);
+
+				start(hint, hiddenSingle, true, value);
+				for(short unsigned int i = 0; i < 9; i++)
+					if(Values[UnitCells[u][i]] == 0 && (Candidates[UnitCells[u][i]] & singles & -singles))
+						hint.Targets[hint.TargetCount++] = UnitCells[u][i];
+				hint.Units[hint.UnitCount++] = u;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Looks for a value whose candidates in a box are all in the same line and which is still
+	 * possible elsewhere in that line (pointing), or whose candidates in a line are all in the same
+	 * box and which is still possible elsewhere in that box (claiming).
+	 */
+	bool Hinter::findLockedCandidates(Hint& hint) const {
+		SUDOKU_TRACE_SPAN("locked candidates");
+
+		for(short unsigned int x = 0; x < 54; x++) {
+			short unsigned int box = 18 + x / 6, line = IntersectionLines[x], shared = 0, boxRest = 0, lineRest = 0;
+
+			for(short unsigned int i = 0; i < 9; i++) {
+				short unsigned int b = UnitCells[box][i], l = UnitCells[line][i];
+
+				if(Values[b] == 0) {
+					if(CellUnits[b][0] == line || CellUnits[b][1] == line)
+						shared |= Candidates[b];
+					else
+						boxRest |= Candidates[b];
+				}
+				if(Values[l] == 0 && CellUnits[l][2] != box)
+					lineRest |= Candidates[l];
+			}
+
+			short unsigned int pointing = shared & ~boxRest & lineRest, claiming = shared & ~lineRest & boxRest;
+
+			if(pointing != 0 || claiming != 0) {
+				short unsigned int from = pointing != 0 ? line : box, value = lowestValue(pointing != 0 ? pointing : claiming);
+
+				start(hint, lockedCandidates, false, value);
+				for(short unsigned int i = 0; i < 9; i++) {
+					short unsigned int c = UnitCells[from][i];
+
+					bool outside = pointing != 0 ? CellUnits[c][2] != box : CellUnits[c][0] != line && CellUnits[c][1] != line;
+
+					if(Values[c] == 0 && outside && (Candidates[c] & (1 << (value - 1))))
+						hint.Targets[hint.TargetCount++] = c;
+				}
+				hint.Units[hint.UnitCount++] = pointing != 0 ? box : line;
+				hint.Units[hint.UnitCount++] = pointing != 0 ? line : box;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Looks for two cells of a unit with the same two candidates, one of them being still possible
+	 * in another cell of the unit.
+	 */
+	bool Hinter::findNakedPair(Hint& hint) const {
+		SUDOKU_TRACE_SPAN("naked pair");
+
+		for(short unsigned int u = 0; u < 27; u++)
+			for(short unsigned int i = 0; i < 8; i++) {
+				short unsigned int first = UnitCells[u][i], pair = Candidates[first];
+
+				if(Values[first] != 0 || countBits(pair) != 2)
+					continue;
+
+				for(short unsigned int j = i + 1; j < 9; j++) {
+					short unsigned int second = UnitCells[u][j], others = 0;
+
+					if(Values[second] != 0 || Candidates[second] != pair)
+						continue;
+
+					for(short unsigned int k = 0; k < 9; k++)
+						if(k != i && k != j && Values[UnitCells[u][k]] == 0)
+							others |= Candidates[UnitCells[u][k]];
+
+					if((others & pair) == 0)
+						continue;
+
+					short unsigned int value = lowestValue(others & pair);
+
+					start(hint, nakedPair, false, value);
+					for(short unsigned int k = 0; k < 9; k++) {
+						short unsigned int c = UnitCells[u][k];
+
+						if(k != i && k != j && Values[c] == 0 && (Candidates[c] & (1 << (value - 1))))
+							hint.Targets[hint.TargetCount++] = c;
+					}
+					hint.Units[hint.UnitCount++] = u;
+					return true;
+				}
+			}
+
+		return false;
+	}
+
+	/**
+	 * Looks for two values fitting only in the same two cells of a unit, one of these cells
+	 * having another candidate.
+	 */
+	bool Hinter::findHiddenPair(Hint& hint) const {
+		SUDOKU_TRACE_SPAN("hidden pair");
+
+		for(short unsigned int u = 0; u < 27; u++) {
+			short unsigned int places[9];
+
+			// places[v - 1] has bit i set if v is possible in the i-th undecided cell of the unit
+			for(short unsigned int v = 0; v < 9; v++) {
+				places[v] = 0;
+				for(short unsigned int i = 0; i < 9; i++)
+					if(Values[UnitCells[u][i]] == 0 && (Candidates[UnitCells[u][i]] & (1 << v)))
+						places[v] |= 1 << i;
+			}
+
+			for(short unsigned int a = 0; a < 8; a++) {
+				if(countBits(places[a]) != 2)
+					continue;
+
+				for(short unsigned int b = a + 1; b < 9; b++) {
+					if(places[b] != places[a])
+						continue;
+
+					short unsigned int first = UnitCells[u][lowestValue(places[a]) - 1],
+						second = UnitCells[u][lowestValue(places[a] & (places[a] - 1)) - 1],
+						others = (Candidates[first] | Candidates[second]) & ~((1 << a) | (1 << b));
+
+					if(others == 0)
+						continue;
+
+					short unsigned int value = lowestValue(others);
+
+					start(hint, hiddenPair, false, value);
+					if(Candidates[first] & (1 << (value - 1)))
+						hint.Targets[hint.TargetCount++] = first;
+					if(Candidates[second] & (1 << (value - 1)))
+						hint.Targets[hint.TargetCount++] = second;
+					hint.Units[hint.UnitCount++] = u;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Looks for a value possible in the same two columns of two rows, and elsewhere in these
+	 * columns, or possible in the same two rows of two columns, and elsewhere in these rows.
+	 */
+	bool Hinter::findXWing(Hint& hint) const {
+		SUDOKU_TRACE_SPAN("x-wing");
+
+		for(short unsigned int v = 0; v < 9; v++)
+			// base 0 are the rows, with the columns as cover; base 9 the other way around
+			for(short unsigned int base = 0; base < 18; base += 9) {
+				short unsigned int cover = 9 - base, places[9];
+
+				for(short unsigned int l = 0; l < 9; l++) {
+					places[l] = 0;
+					for(short unsigned int i = 0; i < 9; i++)
+						if(Values[UnitCells[base + l][i]] == 0 && (Candidates[UnitCells[base + l][i]] & (1 << v)))
+							places[l] |= 1 << i;
+				}
+
+				for(short unsigned int l1 = 0; l1 < 8; l1++) {
+					if(countBits(places[l1]) != 2)
+						continue;
+
+					for(short unsigned int l2 = l1 + 1; l2 < 9; l2++) {
+						if(places[l2] != places[l1])
+							continue;
+
+						short unsigned int c1 = lowestValue(places[l1]) - 1, c2 = lowestValue(places[l1] & (places[l1] - 1)) - 1;
+
+						start(hint, xWing, false, v + 1);
+						for(short unsigned int l = 0; l < 9; l++) {
+							short unsigned int a = UnitCells[cover + c1][l], b = UnitCells[cover + c2][l];
+
+							if(l == l1 || l == l2)
+								continue;
+							if(Values[a] == 0 && (Candidates[a] & (1 << v)))
+								hint.Targets[hint.TargetCount++] = a;
+							if(Values[b] == 0 && (Candidates[b] & (1 << v)))
+								hint.Targets[hint.TargetCount++] = b;
+						}
+
+						if(hint.TargetCount == 0)
+							continue;
+
+						hint.Units[hint.UnitCount++] = base + l1;
+						hint.Units[hint.UnitCount++] = base + l2;
+						hint.Units[hint.UnitCount++] = cover + c1;
+						hint.Units[hint.UnitCount++] = cover + c2;
+						return true;
+					}
+				}
+			}
+
+		return false;
+	}
+
+	/**
+	 * Looks for the easiest logical step over the cached candidates, up to a technique.
+	 * Removals are made on the candidates, placements are left to the caller.
+	 * \arg		hint		set to the step found
+	 * \arg		ceiling		hardest technique tried
+	 * \return	false if a cell has no candidate left or none of the techniques applies
+	 */
+	bool Hinter::find(Hint& hint, tTechnique ceiling) {
+		start(hint, noHint, false, 0);
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(Candidates[c] == 0)
+				return false;
+
+		if(!findNakedSingle(hint) && !(ceiling >= hiddenSingle && findHiddenSingle(hint)) &&
+			!(ceiling >= lockedCandidates && findLockedCandidates(hint)) &&
+			!(ceiling >= nakedPair && findNakedPair(hint)) && !(ceiling >= hiddenPair && findHiddenPair(hint)) &&
+			!(ceiling >= xWing && findXWing(hint)))
+		{
+			start(hint, noHint, false, 0);
+			return false;
+		}
+
+		if(!hint.Place)
+			for(short unsigned int t = 0; t < hint.TargetCount; t++)
+				Candidates[hint.Targets[t]] &= ~(1 << (hint.Value - 1));
+
+		return true;
+	}
+
+	/**
+	 * Returns the easiest logical step of a game.
+	 * Removals are remembered as if the player had made them, so the next call goes on from there.
+	 * \arg		Sudoku	board of the game
+	 * \return	the step, with noHint as technique if the board is solved, if it contradicts itself,
+	 *			or if none of the known techniques applies
+	 */
+	Hint Hinter::next(const Board& Sudoku) {
+		Hint hint;
+
+		sync(Sudoku);
+		find(hint, noHint);
+
+		return hint;
+	}
+
+	/**
+	 * Solves a board with the logical techniques only, following the hints, to grade it.
+	 * \arg		Sudoku	board to solve; the placements of the hints are made on it
+	 * \return	the hardest technique needed, or noHint if the techniques don't solve it
+	 */
+	tTechnique Hinter::grade(Board& Sudoku) {
+		tTechnique hardest = nakedSingle;
+
+		for(;;) {
+			Hint hint = next(Sudoku);
+
+			if(hint.Technique == noHint)
+				break;
+			if(hint.Technique > hardest)
+				hardest = hint.Technique;
+			if(hint.Place && !Sudoku.place(hint.Targets[0] / 9, hint.Targets[0] % 9, hint.Value))
+				return noHint;
+		}
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(Values[c] == 0)
+				return noHint;
+
+		return hardest;
+	}
+
+	/**
+	 * Solves a puzzle with the logical techniques up to a ceiling, to grade it without a Board.
+	 * It stops as soon as only a harder technique would go on, so a puzzle harder than wanted is
+	 * found out early. A puzzle solved this way has a single solution. The last board is forgotten.
+	 * \arg		values		the 81 cells, 0 for the empty ones
+	 * \arg		ceiling		hardest technique allowed
+	 * \return	the hardest technique needed, or noHint if the techniques up to the ceiling don't
+	 *			solve it
+	 */
+	tTechnique Hinter::grade(const short unsigned int* values, tTechnique ceiling) {
+		tTechnique hardest = nakedSingle;
+		short unsigned int unsolved = 81;
+		Hint hint;
+
+		Source = 0;
+		for(short unsigned int c = 0; c < 81; c++) {
+			Candidates[c] = 0x1FF;
+			Values[c] = 0;
+		}
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(values[c] != 0) {
+				if(!(Candidates[c] & (1 << (values[c] - 1))))
+					return noHint;
+				apply(c, values[c]);
+				unsolved--;
+			}
+
+		while(unsolved > 0 && find(hint, ceiling)) {
+			if(hint.Technique > hardest)
+				hardest = hint.Technique;
+			if(hint.Place) {
+				apply(hint.Targets[0], hint.Value);
+				unsolved--;
+			}
+		}
+
+		return unsolved == 0 ? hardest : noHint;
+	}
+
+	/**
+	 * Forgets the cached candidates, so that the next call rebuilds them from the board.
+	 */
+	void Hinter::reset() {
+		Source = 0;
+	}
+
+	/**
+	 * Returns the candidates bitmask of a cell, as known after the last hint.
+	 * \arg		cell	index of the cell, in the range [0,80]
+	 */
+	short unsigned int Hinter::getCandidates(short unsigned int cell) const {
+		return Candidates[cell];
+	}
+}
+}
@@ -0,0 +1,84 @@
+// See COPYING file for licensing information.
+/**
+ * \file hint.h
+ * Definition of the engine giving the next logical step of a game.
+ */
+
+#ifndef HINT_H
+#define HINT_H
+
+#include "sudoku.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Logical techniques, from the easiest to the hardest one:
+	 * - nakedSingle: a cell has a single candidate left
+	 * - hiddenSingle: a value fits in a single cell of a unit
+	 * - lockedCandidates: the candidates of a value in a box are all in one line, or the other way
+	 *   around, so the value can be removed from the rest of that line (or box)
+	 * - nakedPair: two cells of a unit have the same two candidates, which can be removed from the
+	 *   rest of the unit
+	 * - hiddenPair: two values fit only in the same two cells of a unit, so the other candidates of
+	 *   these cells can be removed
+	 * - xWing: a value fits in the same two columns of two rows (or the other way around), so it can
+	 *   be removed from the rest of these columns (or rows)
+	 * - noHint: none of the above applies, or the board is solved
+	 */
+	typedef enum{nakedSingle,hiddenSingle,lockedCandidates,nakedPair,hiddenPair,xWing,noHint} tTechnique;
+
+	/**
+	 * A logical step. It either places Value in the single target cell, or removes Value from the
+	 * candidates of every target cell. Units lists the units, numbered as in tables.h, which justify
+	 * the step: the units of the cell for a naked single, the unit where the value is hidden for a
+	 * hidden single, the box and the line for locked candidates, the unit of the pair, or the two
+	 * base lines followed by the two cover lines of an x-wing.
+	 */
+	typedef struct {
+		tTechnique Technique;
+		bool Place;
+		short unsigned int Value;
+		short unsigned int Targets[20];
+		short unsigned int TargetCount;
+		short unsigned int Units[4];
+		short unsigned int UnitCount;
+	} Hint;
+
+	/**
+	 * Finds the easiest logical step of a game without solving it.
+	 * The techniques are tried from the cheapest to the most expensive and the first step found is
+	 * returned. A Hinter keeps the candidates of the last board it was asked about: while the game
+	 * only goes on through Board::place, the new moves are applied to them instead of rebuilding
+	 * them, and the removals given as hints are remembered, so that successive calls make progress
+	 * even if the player doesn't write pencil marks.
+	 */
+	class Hinter {
+		short unsigned int Candidates[81];
+		short unsigned int Values[81];
+		const Board* Source;
+		unsigned long Identity, Version;
+		size_t Moves;
+
+		void load(const Board& Sudoku);
+		void apply(short unsigned int c, short unsigned int value);
+		void sync(const Board& Sudoku);
+
+		bool findNakedSingle(Hint& hint) const;
+		bool findHiddenSingle(Hint& hint) const;
+		bool findLockedCandidates(Hint& hint) const;
+		bool findNakedPair(Hint& hint) const;
+		bool findHiddenPair(Hint& hint) const;
+		bool findXWing(Hint& hint) const;
+		bool find(Hint& hint, tTechnique ceiling);
+	public:
+		Hinter();
+
+		Hint next(const Board& Sudoku);
+		tTechnique grade(Board& Sudoku);
+		tTechnique grade(const short unsigned int* values, tTechnique ceiling = noHint);
+		void reset();
+		short unsigned int getCandidates(short unsigned int cell) const;
+	};
+}
+}
+#endif
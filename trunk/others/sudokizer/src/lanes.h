@@ -0,0 +1,112 @@
+// See COPYING file for licensing information.
+/**
+ * \file lanes.h
+ * SIMD lanes of 16 bits and the few operations on them that Batch and Validator need, wrapped so
+ * that their code is written once for AVX2, SSE2 and plain code.
+ */
+
+#ifndef LANES_H
+#define LANES_H
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SUDOKU_LANES 16
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SUDOKU_LANES 8
+#else
+#define SUDOKU_LANES 8
+#endif
+
+namespace std {
+namespace sudoku {
+	/**
+	 * The candidates bitmasks of one cell in SUDOKU_LANES boards, one board per 16 bits lane:
+	 * 16 lanes with AVX2, 8 with SSE2, and 8 handled one by one by plain code otherwise.
+	 */
+#if defined(__AVX2__)
+	typedef __m256i Lanes;
+#elif defined(__SSE2__)
+	typedef __m128i Lanes;
+#else
+	typedef struct {
+		short unsigned int Lane[SUDOKU_LANES];
+	} Lanes;
+#endif
+
+	// splat: every lane set to a value; both, either, differ and butNot: and, or, xor and and not
+	// of each lane; isZero: 0xFFFF in the lanes which are 0, 0 in the others; any: whether a lane
+	// isn't 0; same: whether every lane is equal; pack and unpack: from and to an array
+#if defined(__AVX2__)
+	static inline Lanes splat(short unsigned int v) { return _mm256_set1_epi16(v); }
+	static inline Lanes both(Lanes a, Lanes b) { return _mm256_and_si256(a, b); }
+	static inline Lanes either(Lanes a, Lanes b) { return _mm256_or_si256(a, b); }
+	static inline Lanes differ(Lanes a, Lanes b) { return _mm256_xor_si256(a, b); }
+	static inline Lanes butNot(Lanes a, Lanes b) { return _mm256_andnot_si256(b, a); }
+	static inline Lanes decrement(Lanes a) { return _mm256_sub_epi16(a, _mm256_set1_epi16(1)); }
+	static inline Lanes isZero(Lanes a) { return _mm256_cmpeq_epi16(a, _mm256_setzero_si256()); }
+	static inline bool any(Lanes a) { return !_mm256_testz_si256(a, a); }
+	static inline bool same(Lanes a, Lanes b) { return _mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b)) == -1; }
+	static inline void unpack(Lanes a, short unsigned int* lanes) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), a); }
+	static inline Lanes pack(const short unsigned int* lanes) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes)); }
+#elif defined(__SSE2__)
+	static inline Lanes splat(short unsigned int v) { return _mm_set1_epi16(v); }
+	static inline Lanes both(Lanes a, Lanes b) { return _mm_and_si128(a, b); }
+	static inline Lanes either(Lanes a, Lanes b) { return _mm_or_si128(a, b); }
+	static inline Lanes differ(Lanes a, Lanes b) { return _mm_xor_si128(a, b); }
+	static inline Lanes butNot(Lanes a, Lanes b) { return _mm_andnot_si128(b, a); }
+	static inline Lanes decrement(Lanes a) { return _mm_sub_epi16(a, _mm_set1_epi16(1)); }
+	static inline Lanes isZero(Lanes a) { return _mm_cmpeq_epi16(a, _mm_setzero_si128()); }
+	static inline bool any(Lanes a) { return _mm_movemask_epi8(_mm_cmpeq_epi16(a, _mm_setzero_si128())) != 0xFFFF; }
+	static inline bool same(Lanes a, Lanes b) { return _mm_movemask_epi8(_mm_cmpeq_epi16(a, b)) == 0xFFFF; }
+	static inline void unpack(Lanes a, short unsigned int* lanes) { _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), a); }
+	static inline Lanes pack(const short unsigned int* lanes) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes)); }
+#else
+	static inline Lanes splat(short unsigned int v) {
+		Lanes r;
+		for(short unsigned int i = 0; i < SUDOKU_LANES; i++) r.Lane[i] = v;
+		return r;
+	}
+	static inline Lanes both(Lanes a, Lanes b) {
+		for(short unsigned int i = 0; i < SUDOKU_LANES; i++) a.Lane[i] &= b.Lane[i];
+		return a;
+	}
+	static inline Lanes either(Lanes a, Lanes b) {
+		for(short unsigned int i = 0; i < SUDOKU_LANES; i++) a.Lane[i] |= b.Lane[i];
+		return a;
+	}
+	static inline Lanes differ(Lanes a, Lanes b) {
+		for(short unsigned int i = 0; i < SUDOKU_LANES; i++) a.Lane[i] ^= b.Lane[i];
+		return a;
+	}
+	static inline Lanes butNot(Lanes a, Lanes b) {
+		for(short unsigned int i = 0; i < SUDOKU_LANES; i++) a.Lane[i] &= ~b.Lane[i];
+		return a;
+	}
+	static inline Lanes decrement(Lanes a) {
+		for(short unsigned int i = 0; i < SUDOKU_LANES; i++) a.Lane[i]--;
+		return a;
+	}
+	static inline Lanes isZero(Lanes a) {
+		for(short unsigned int i = 0; i < SUDOKU_LANES; i++) a.Lane[i] = a.Lane[i] == 0 ? 0xFFFF : 0;
+		return a;
+	}
+	static inline bool any(Lanes a) {
+		for(short unsigned int i = 0; i < SUDOKU_LANES; i++) if(a.Lane[i]) return true;
+		return false;
+	}
+	static inline bool same(Lanes a, Lanes b) {
+		return memcmp(&a, &b, sizeof(Lanes)) == 0;
+	}
+	static inline void unpack(Lanes a, short unsigned int* lanes) { memcpy(lanes, a.Lane, sizeof(a.Lane)); }
+	static inline Lanes pack(const short unsigned int* lanes) {
+		Lanes r;
+		memcpy(r.Lane, lanes, sizeof(r.Lane));
+		return r;
+	}
+#endif
+}
+}
+#endif
@@ -0,0 +1,98 @@
+// See COPYING file for licensing information.
+/**
+ * \file libsudoku.cpp
+ * Implementation of the plain C interface to the sudoku solver.
+ * It only uses the sequential Search on a Grid living in the stack, so no call allocates memory.
+ */
+#include "libsudoku.h"
+#include "search.h"
+
+using namespace std;
+using namespace sudoku;
+
+/**
+ * Loads a puzzle given as 81 characters into a Grid.
+ * \return	SUDOKU_SOLVED if it was loaded, SUDOKU_UNSOLVABLE if the givens contradict each other,
+ *			or SUDOKU_INVALID if there's an unknown character
+ */
+static int load(const char in[81], Grid& grid) {
+	for(short unsigned int c = 0; c < 81; c++)
+		if(in[c] != '.' && (in[c] < '0' || in[c] > '9'))
+			return SUDOKU_INVALID;
+
+	for(short unsigned int c = 0; c < 81; c++)
+		if(in[c] >= '1' && in[c] <= '9' && !grid.assign(c, in[c] - '0'))
+			return SUDOKU_UNSOLVABLE;
+
+	return SUDOKU_SOLVED;
+}
+
+/**
+ * Visitor of the enumeration keeping the first solution found in the grid given as context.
+ */
+static bool keep(const Grid& solution, void* context) {
+	Grid& first = *static_cast<Grid*>(context);
+
+	if(!first.isSolved())
+		first = solution;
+	return true;
+}
+
+int sudoku_solve(const char in[81], char out[81], const sudoku_opts* opts) {
+	Budget budget(opts != 0 ? opts->max_millis / 1000.0 : 0, opts != 0 ? opts->max_nodes : 0,
+		opts != 0 ? opts->cancel : 0);
+	Grid grid;
+	int result = load(in, grid);
+
+	if(result != SUDOKU_SOLVED)
+		return result;
+
+	if(opts != 0 && opts->check_unique) {
+		// Enumerating up to two solutions finds the one to write and checks it's alone at once
+		Grid first = grid;
+		unsigned long found = Search::enumerate(grid, keep, &first, budget, 2);
+
+		if(budget.exceeded())
+			return SUDOKU_BUDGET;
+		if(found == 0)
+			return SUDOKU_UNSOLVABLE;
+
+		grid = first;
+		if(found > 1)
+			result = SUDOKU_MULTIPLE;
+	} else if(!Search::solve(grid, budget))
+		return budget.exceeded() ? SUDOKU_BUDGET : SUDOKU_UNSOLVABLE;
+
+	for(short unsigned int c = 0; c < 81; c++)
+		out[c] = '0' + grid.get(c);
+
+	return result;
+}
+
+unsigned long sudoku_count(const char in[81], unsigned long limit) {
+	Grid grid;
+	int result = load(in, grid);
+
+	if(result == SUDOKU_INVALID || result == SUDOKU_UNSOLVABLE)
+		return 0;
+
+	return Search::count(grid, limit);
+}
+
+int sudoku_count_opts(const char in[81], unsigned long limit, const sudoku_opts* opts, unsigned long* count) {
+	Budget budget(opts != 0 ? opts->max_millis / 1000.0 : 0, opts != 0 ? opts->max_nodes : 0,
+		opts != 0 ? opts->cancel : 0);
+	Grid grid;
+	int result = load(in, grid);
+
+	*count = 0;
+	if(result != SUDOKU_SOLVED)
+		return result;
+
+	*count = Search::count(grid, budget, limit);
+
+	if(budget.exceeded())
+		return SUDOKU_BUDGET;
+
+	return *count == 0 ? SUDOKU_UNSOLVABLE : *count == 1 ? SUDOKU_SOLVED : SUDOKU_MULTIPLE;
+}
@@ -0,0 +1,61 @@
+/* See COPYING file for licensing information. */
+/**
+ * \file libsudoku.h
+ * Plain C interface to the sudoku solver, to embed it in other programs.
+ * None of these functions allocate memory, write to the standard output or throw exceptions.
+ */
+
+#ifndef LIBSUDOKU_H
+#define LIBSUDOKU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Results returned by sudoku_solve() and sudoku_count_opts() */
+enum {
+	SUDOKU_SOLVED = 0,		/**< the puzzle was solved */
+	SUDOKU_UNSOLVABLE = 1,	/**< the puzzle has no solution */
+	SUDOKU_MULTIPLE = 2,	/**< the puzzle has more than one solution; only if check_unique was set */
+	SUDOKU_INVALID = 3,		/**< the input contains an unknown character */
+	SUDOKU_BUDGET = 4		/**< the search was stopped by max_nodes, max_millis or cancel */
+};
+
+/** Options for sudoku_solve() and sudoku_count_opts(). A null pointer means all of them set to 0. */
+typedef struct sudoku_opts {
+	int check_unique;		/**< if not 0, also check that the solution is the only one */
+	unsigned long max_nodes;	/**< if not 0, search branches allowed */
+	unsigned long max_millis;	/**< if not 0, milliseconds allowed */
+	volatile int* cancel;	/**< if not null, setting it to non 0 from another thread stops the search */
+} sudoku_opts;
+
+/**
+ * Solves a puzzle given as 81 characters, row by row: '1' to '9' for the givens and '0' or '.'
+ * for the empty cells. The solution is written in the same format, with no trailing '\\0'.
+ * \return	one of the SUDOKU_* results; out is only written for SUDOKU_SOLVED and SUDOKU_MULTIPLE
+ */
+int sudoku_solve(const char in[81], char out[81], const sudoku_opts* opts);
+
+/**
+ * Counts the solutions of a puzzle given in the same format as for sudoku_solve().
+ * There is no limit but the given one, so a puzzle with few givens may take practically forever
+ * with limit 0; sudoku_count_opts() has a budget.
+ * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+ * \return	the number of solutions, or 0 if the input is invalid
+ */
+unsigned long sudoku_count(const char in[81], unsigned long limit);
+
+/**
+ * Counts the solutions of a puzzle within the budget of the options; check_unique is ignored.
+ * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+ * \arg		count	set to the number of solutions found, only a lower bound for SUDOKU_BUDGET
+ * \return	SUDOKU_UNSOLVABLE, SUDOKU_SOLVED or SUDOKU_MULTIPLE for none, one or more solutions,
+ *			SUDOKU_INVALID, or SUDOKU_BUDGET if the count was stopped
+ */
+int sudoku_count_opts(const char in[81], unsigned long limit, const sudoku_opts* opts, unsigned long* count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,322 @@
+// See COPYING file for licensing information.
+/**
+ * \file parser.cpp
+ * Implementation of the reading of puzzles from text in the usual interchange formats.
+ */
+#include "parser.h"
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Gets the next line of a text, without its end of line.
+	 * \arg		position	where the line starts, moved to the start of the following one
+	 * \arg		end			end of the text
+	 * \arg		begin		set to the first character of the line
+	 * \arg		stop		set past the last character of the line, before any "\r\n" or "\n"
+	 * \return	false at the end of the text
+	 */
+	static inline bool nextLine(const char*& position, const char* end, const char*& begin, const char*& stop) {
+		if(position >= end)
+			return false;
+
+		const char* newline = static_cast<const char*>(memchr(position, '\n', end - position));
+
+		begin = position;
+		stop = newline ? newline : end;
+		position = newline ? newline + 1 : end;
+		if(stop > begin && stop[-1] == '\r')
+			stop--;
+
+		return true;
+	}
+
+	/**
+	 * Tells whether a line is a comment: empty, blank, or starting with '#' or '['.
+	 */
+	static bool comment(const char* begin, const char* end) {
+		if(begin < end && (*begin == '#' || *begin == '['))
+			return true;
+
+		for(; begin < end; begin++)
+			if(*begin != ' ' && *begin != '\t')
+				return false;
+
+		return true;
+	}
+
+	/**
+	 * Tells whether a line only draws the frame of a grid, like the lines between the bands or the
+	 * "*-----------*" above and below the grids of Simple Sudoku.
+	 */
+	static bool frame(const char* begin, const char* end) {
+		for(; begin < end; begin++)
+			if(strchr("-=+|#* \t", *begin) == 0)
+				return false;
+
+		return true;
+	}
+
+	/**
+	 * Returns the value of a cell character: 1 to 9 for the givens, 0 for '0' and '.', or -1 if it
+	 * isn't a cell.
+	 */
+	static inline int cell(char c) {
+		if(c >= '0' && c <= '9')
+			return c - '0';
+
+		return c == '.' ? 0 : -1;
+	}
+
+	/**
+	 * Builds a parser of a text, detecting its format.
+	 * \arg		text	the text; it isn't copied
+	 * \arg		length	its size in bytes
+	 */
+	Parser::Parser(const char* text, size_t length)
+		: Text(text), End(text + length), Position(text), Input(detect(text, length)), Skipped(0)
+	{
+	}
+
+	/**
+	 * Detects the format of a text from its first line which isn't a comment.
+	 * \arg		text	the text
+	 * \arg		length	its size in bytes
+	 * \return	its format, or unknownInput if no puzzle can be read from it
+	 */
+	tInput Parser::detect(const char* text, size_t length) {
+		const char* position = text;
+		const char* end = text + length;
+		const char *begin, *stop;
+		short unsigned int values[81];
+
+		while(nextLine(position, end, begin, stop)) {
+			if(comment(begin, stop))
+				continue;
+
+			size_t size = stop - begin;
+
+			// Display::show clears the screen first, and its header and rows have "||" between the boxes
+			if(*begin == '\033' || memmem(begin, size, "||", 2) != 0)
+				return prettyInput;
+			if(memchr(begin, '|', size) != 0 || frame(begin, stop))
+				return ssInput;
+			if(size >= 81 && parse(begin, values))
+				return lineInput;
+
+			short unsigned int cells = 0;
+
+			while(begin < stop && cell(*begin) >= 0) {
+				begin++;
+				cells++;
+			}
+			return (cells == 9 && comment(begin, stop)) ? sdkInput : unknownInput;
+		}
+
+		return unknownInput;
+	}
+
+	/**
+	 * Reads 81 cells, row by row.
+	 * \arg		text	the cells: '1' to '9' for the givens, '0' or '.' for the empty ones
+	 * \arg		values	set to the values of the 81 cells, 0 for the empty ones
+	 * \return	false if a character isn't a cell; values is then undefined
+	 */
+	bool Parser::parse(const char* text, short unsigned int* values) {
+		short unsigned int c = 0;
+
+#if defined(__SSE2__)
+		const __m128i zero = _mm_setzero_si128(), dot = _mm_set1_epi8('.'),
+			base = _mm_set1_epi8('0'), nine = _mm_set1_epi8(9);
+
+		// A byte is a digit if its distance to '0' is at most 9 as an unsigned number
+		for(; c + 16 <= 81; c += 16) {
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + c));
+			__m128i dots = _mm_cmpeq_epi8(bytes, dot);
+			__m128i digits = _mm_sub_epi8(bytes, base);
+			__m128i valid = _mm_or_si128(dots, _mm_cmpeq_epi8(_mm_max_epu8(digits, nine), nine));
+
+			if(_mm_movemask_epi8(valid) != 0xFFFF)
+				return false;
+
+			digits = _mm_andnot_si128(dots, digits);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(values + c), _mm_unpacklo_epi8(digits, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(values + c + 8), _mm_unpackhi_epi8(digits, zero));
+		}
+#endif
+
+		for(; c < 81; c++) {
+			int value = cell(text[c]);
+
+			if(value < 0)
+				return false;
+			values[c] = value;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Reads a row of 9 cells from a line in the format of the parser.
+	 * \arg		begin	first character of the line
+	 * \arg		end		past the last character of the line
+	 * \arg		values	set to the values of the 9 cells, 0 for the empty ones
+	 * \return	false if the line isn't a row
+	 */
+	bool Parser::row(const char* begin, const char* end, short unsigned int* values) const {
+		short unsigned int cells = 0;
+
+		if(Input == prettyInput) {
+			// " 1 || 5 | 3 |   || ...": after the coordinate, each cell is the text before a '|',
+			// blank if it's empty; the text between two '|' of a "||" isn't a cell
+			const char* bar = static_cast<const char*>(memmem(begin, end - begin, "||", 2));
+
+			if(bar == 0)
+				return false;
+
+			for(const char* from = bar + 2; from < end && cells < 9; from++) {
+				const char* to = static_cast<const char*>(memchr(from, '|', end - from));
+
+				if(to == 0)
+					return false;
+
+				if(to > from) {
+					int value = 0;
+					bool seen = false;
+
+					for(; from < to; from++) {
+						if(*from == ' ')
+							continue;
+						if(seen || (value = cell(*from)) < 0)
+							return false;
+						seen = true;
+					}
+					values[cells++] = value;
+				}
+				from = to;
+			}
+
+			return cells == 9;
+		}
+
+		// Simple Sudoku and SadMan rows: the cells, maybe with '|' and blanks between the boxes
+		for(; begin < end; begin++) {
+			if(*begin == '|' || *begin == ' ' || *begin == '\t')
+				continue;
+
+			int value = cell(*begin);
+
+			if(value < 0 || cells == 9)
+				return false;
+			values[cells++] = value;
+		}
+
+		return cells == 9;
+	}
+
+	/**
+	 * Reads the next puzzle of the text.
+	 * \arg		values	set to the values of the 81 cells, row by row, 0 for the empty ones
+	 * \return	false at the end of the text
+	 */
+	bool Parser::next(short unsigned int* values) {
+		const char *begin, *end;
+		short unsigned int rows = 0;
+
+		if(Input == unknownInput)
+			return false;
+
+		while(nextLine(Position, End, begin, end)) {
+			if(comment(begin, end))
+				continue;
+
+			if(Input == lineInput) {
+				if(end - begin >= 81 && parse(begin, values))
+					return true;
+				Skipped++;
+				continue;
+			}
+
+			if(frame(begin, end))
+				continue;
+
+			// The header of Display::show and any other line not starting with a coordinate
+			if(Input == prettyInput) {
+				const char* first = begin;
+
+				while(first < end && *first == ' ')
+					first++;
+				if(first == end || *first < '1' || *first > '9')
+					continue;
+			}
+
+			if(row(begin, end, values + rows * 9)) {
+				if(++rows == 9)
+					return true;
+			} else {
+				// The rows read so far belong to a broken puzzle
+				Skipped += rows + 1;
+				rows = 0;
+			}
+		}
+
+		Skipped += rows;
+		return false;
+	}
+
+	/**
+	 * Reads the next puzzle of the text into a search Grid.
+	 * \arg		grid	set to the givens of the puzzle, propagated
+	 * \arg		valid	set to false if the givens contradict each other
+	 * \return	false at the end of the text
+	 */
+	bool Parser::next(Grid& grid, bool& valid) {
+		short unsigned int values[81];
+
+		if(!next(values))
+			return false;
+
+		grid = Grid();
+		valid = true;
+		for(short unsigned int c = 0; c < 81 && valid; c++)
+			if(values[c] != 0)
+				valid = grid.assign(c, values[c]);
+
+		return true;
+	}
+
+	/**
+	 * Goes back to the first puzzle of the text.
+	 */
+	void Parser::rewind() {
+		Position = Text;
+		Skipped = 0;
+	}
+
+	/**
+	 * Returns the format detected for the text.
+	 */
+	tInput Parser::getInput() const {
+		return Input;
+	}
+
+	/**
+	 * Returns the number of lines skipped so far because they didn't fit in the format.
+	 */
+	unsigned long Parser::getSkipped() const {
+		return Skipped;
+	}
+
+	/**
+	 * Returns the name of a format.
+	 */
+	const char* Parser::name(tInput input) {
+		static const char* names[] = {"line", "pretty", "sdk", "ss", "unknown"};
+
+		return names[input];
+	}
+}
+}
@@ -0,0 +1,56 @@
+// See COPYING file for licensing information.
+/**
+ * \file parser.h
+ * Definition of the reading of puzzles from text in the usual interchange formats.
+ */
+
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "search.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Text formats of puzzles which can be read:
+	 * - lineInput: 81 cells per line, row by row, '0' or '.' for the empty ones; the rest of the
+	 *   line is ignored
+	 * - prettyInput: the grid with its coordinates, as it's shown by Display::show
+	 * - sdkInput: SadMan Sudoku, 9 lines of 9 cells
+	 * - ssInput: Simple Sudoku, 9 lines of 9 cells with '|' between the boxes and lines of '-'
+	 *   between the bands, maybe framed by lines of '*' and '-'
+	 * - unknownInput: none of the above
+	 * In every format, empty lines and lines starting with '#' or '[' are comments.
+	 */
+	typedef enum{lineInput,prettyInput,sdkInput,ssInput,unknownInput} tInput;
+
+	/**
+	 * Reader of the puzzles of a text, one after the other.
+	 * The format is detected once, from the first lines of the text, and every puzzle is read in it;
+	 * the lines which don't fit are skipped. The text isn't copied, so it has to outlive the Parser.
+	 * Lines of 81 cells are the bulk format, so they're checked 16 bytes at once when SSE2 is there.
+	 */
+	class Parser {
+		const char* Text;
+		const char* End;
+		const char* Position;
+		tInput Input;
+		unsigned long Skipped;
+
+		bool row(const char* begin, const char* end, short unsigned int* values) const;
+	public:
+		Parser(const char* text, size_t length);
+
+		bool next(short unsigned int* values);
+		bool next(Grid& grid, bool& valid);
+		void rewind();
+		tInput getInput() const;
+		unsigned long getSkipped() const;
+
+		static tInput detect(const char* text, size_t length);
+		static bool parse(const char* text, short unsigned int* values);
+		static const char* name(tInput input);
+	};
+}
+}
+#endif
@@ -0,0 +1,386 @@
+// See COPYING file for licensing information.
+/**
+ * \file pool.cpp
+ * Implementation of the pool of puzzles generated in the background, by difficulty.
+ */
+#include "pool.h"
+#include "search.h"
+#include "carver.h"
+#include "trace.h"
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Ring constructor.
+	 * \arg		capacity	number of entries it can hold, rounded up to a power of two
+	 */
+	Ring::Ring(unsigned long capacity)
+		: Mask(1), Head(0), Tail(0)
+	{
+		while(Mask < capacity)
+			Mask <<= 1;
+
+		Slots = new Slot[Mask];
+		for(unsigned long i = 0; i < Mask; i++)
+			Slots[i].Sequence = i;
+		Mask--;
+	}
+
+	/**
+	 * Ring destructor.
+	 */
+	Ring::~Ring() {
+		delete[] Slots;
+	}
+
+	/**
+	 * Adds an entry at the tail.
+	 * \return	false if the ring is full
+	 */
+	bool Ring::push(const Entry& entry) {
+		unsigned long position = Tail;
+		Slot* slot;
+
+		for(;;) {
+			slot = &Slots[position & Mask];
+			long difference = static_cast<long>(slot->Sequence - position);
+
+			if(difference == 0 && __sync_bool_compare_and_swap(&Tail, position, position + 1))
+				break;
+			else if(difference < 0)
+				return false;
+			else
+				position = Tail;
+		}
+
+		slot->Data = entry;
+		__sync_synchronize();
+		slot->Sequence = position + 1;
+		return true;
+	}
+
+	/**
+	 * Takes the entry at the head.
+	 * \return	false if the ring is empty
+	 */
+	bool Ring::pop(Entry& entry) {
+		unsigned long position = Head;
+		Slot* slot;
+
+		for(;;) {
+			slot = &Slots[position & Mask];
+			long difference = static_cast<long>(slot->Sequence - (position + 1));
+
+			if(difference == 0 && __sync_bool_compare_and_swap(&Head, position, position + 1))
+				break;
+			else if(difference < 0)
+				return false;
+			else
+				position = Head;
+		}
+
+		entry = slot->Data;
+		__sync_synchronize();
+		slot->Sequence = position + Mask + 1;
+		return true;
+	}
+
+	/**
+	 * Copies the entries from the head on without taking them out of the ring. An entry which
+	 * another thread takes while it's being copied is left out, as well as one not written yet.
+	 * \arg		entries	where to copy them
+	 * \arg		count	the most entries to copy
+	 * \return	the number of entries copied
+	 */
+	unsigned long Ring::peek(Entry* entries, unsigned long count) const {
+		unsigned long tail = Tail, n = 0;
+
+		for(unsigned long position = Head; position != tail && n < count; position++) {
+			const Slot& slot = Slots[position & Mask];
+
+			// The slot holds the entry of this position while its sequence number is the one left
+			// by push(), before the copy as well as after it
+			if(slot.Sequence != position + 1)
+				continue;
+			__sync_synchronize();
+			entries[n] = slot.Data;
+			__sync_synchronize();
+			if(slot.Sequence == position + 1)
+				n++;
+		}
+
+		return n;
+	}
+
+	/**
+	 * Returns the number of entries, which may be already stale when other threads are using it.
+	 */
+	unsigned long Ring::size() const {
+		unsigned long head = Head, tail = Tail;
+
+		return tail > head ? tail - head : 0;
+	}
+
+	/**
+	 * Returns the number of entries it can hold.
+	 */
+	unsigned long Ring::capacity() const {
+		return Mask + 1;
+	}
+
+	/**
+	 * Pool constructor. No thread is started yet.
+	 * \arg		capacity	number of puzzles each tier can hold, rounded up to a power of two; the
+	 *						watermarks start at a quarter of it and at all of it
+	 */
+	Pool::Pool(unsigned long capacity)
+		: Threads(0), Running(0), Stop(0)
+	{
+		for(short unsigned int t = 0; t < 4; t++) {
+			Rings[t] = new Ring(capacity);
+			Low[t] = Rings[t]->capacity() / 4;
+			High[t] = Rings[t]->capacity();
+		}
+	}
+
+	/**
+	 * Pool destructor. Stops the threads.
+	 */
+	Pool::~Pool() {
+		stop();
+		for(short unsigned int t = 0; t < 4; t++)
+			delete Rings[t];
+	}
+
+	/**
+	 * Sets the watermarks of a tier: the threads generate while it has fewer than low puzzles,
+	 * and keep the puzzles they get for it while it has fewer than high.
+	 */
+	void Pool::setWatermarks(tDifficulty difficulty, unsigned long low, unsigned long high) {
+		Low[difficulty] = low;
+		High[difficulty] = high < Rings[difficulty]->capacity() ? high : Rings[difficulty]->capacity();
+	}
+
+	/**
+	 * Returns the tier of a puzzle from the hardest technique it needs.
+	 */
+	tDifficulty Pool::tier(tTechnique hardest) {
+		switch(hardest) {
+			case nakedSingle:
+			case hiddenSingle:
+				return easy;
+			case lockedCandidates:
+				return medium;
+			case nakedPair:
+			case hiddenPair:
+			case xWing:
+				return hard;
+			default:
+				return expert;
+		}
+	}
+
+	/**
+	 * States if some tier is below its low watermark.
+	 */
+	bool Pool::hungry() const {
+		for(short unsigned int t = 0; t < 4; t++)
+			if(Rings[t]->size() < Low[t])
+				return true;
+
+		return false;
+	}
+
+	/**
+	 * Returns the tier furthest below its low watermark.
+	 */
+	tDifficulty Pool::neediest() const {
+		tDifficulty neediest = easy;
+		unsigned long missing = 0;
+
+		for(short unsigned int t = 0; t < 4; t++)
+			if(Rings[t]->size() < Low[t] && Low[t] - Rings[t]->size() > missing) {
+				missing = Low[t] - Rings[t]->size();
+				neediest = static_cast<tDifficulty>(t);
+			}
+
+		return neediest;
+	}
+
+	/**
+	 * Generates a puzzle for the tier furthest below its low watermark and puts it in the pool,
+	 * unless its tier is above its high watermark.
+	 * The Carver digs the puzzle straight into the band of the tier; if it can't within a few
+	 * solutions, the last puzzle dug goes to its own tier.
+	 * \arg		seed	state of the random numbers of the calling thread
+	 * \arg		table	subtrees searched by the calling thread, kept from one puzzle to the next
+	 */
+	void Pool::produce(unsigned int& seed, TranspositionTable& table) {
+		SUDOKU_TRACE_SPAN("pool puzzle");
+		static const tTechnique lowest[] = {nakedSingle, lockedCandidates, nakedPair, noHint},
+			highest[] = {hiddenSingle, lockedCandidates, xWing, noHint};
+		tDifficulty wanted = neediest();
+		Carver carver(&table);
+		Budget budget(0, 16, &Stop);
+		Entry entry;
+
+		const short unsigned int* puzzle = carver.getPuzzle();
+		const short unsigned int* solution = carver.getSolution();
+
+		// Until it digs a puzzle, a Carver has no solution
+		if(!carver.generate(lowest[wanted], highest[wanted], seed, budget) && solution[0] == 0)
+			return;
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			entry.Puzzle[c] = puzzle[c] != 0 ? '0' + puzzle[c] : '.';
+			entry.Solution[c] = '0' + solution[c];
+		}
+
+		tDifficulty difficulty = tier(carver.getGrade());
+
+		if(Rings[difficulty]->size() < High[difficulty])
+			Rings[difficulty]->push(entry);
+	}
+
+	/**
+	 * Body of the generating threads.
+	 * \arg		pool	the Pool
+	 */
+	void* Pool::worker(void* pool) {
+		Pool& Owner = *static_cast<Pool*>(pool);
+		unsigned int seed = time(0) ^ reinterpret_cast<unsigned long>(&seed);
+		TranspositionTable table;
+
+		while(!Owner.Stop) {
+			if(Owner.hungry())
+				Owner.produce(seed, table);
+			else
+				usleep(10000);
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Starts the generating threads.
+	 * \arg		threads	number of threads, or 0 for one per processor
+	 * \return	false if they were already started or none could be started
+	 */
+	bool Pool::start(short unsigned int threads) {
+		if(Threads != 0)
+			return false;
+
+		if(threads == 0)
+			threads = Search::cores();
+
+		Stop = 0;
+		Threads = new pthread_t[threads];
+		for(Running = 0; Running < threads; Running++)
+			if(pthread_create(&Threads[Running], 0, worker, this) != 0)
+				break;
+
+		if(Running == 0) {
+			delete[] Threads;
+			Threads = 0;
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Stops the generating threads, waiting for the puzzle each of them is working on.
+	 */
+	void Pool::stop() {
+		if(Threads == 0)
+			return;
+
+		Stop = 1;
+		for(short unsigned int i = 0; i < Running; i++)
+			pthread_join(Threads[i], 0);
+
+		delete[] Threads;
+		Threads = 0;
+		Running = 0;
+	}
+
+	/**
+	 * Takes a puzzle with its solution out of a tier, without locking.
+	 * \return	false if the tier is empty
+	 */
+	bool Pool::take(tDifficulty difficulty, Entry& entry) {
+		return Rings[difficulty]->pop(entry);
+	}
+
+	/**
+	 * Puts a puzzle with its solution in a tier, like the generating threads do.
+	 * \return	false if the tier is full
+	 */
+	bool Pool::put(tDifficulty difficulty, const Entry& entry) {
+		return Rings[difficulty]->push(entry);
+	}
+
+	/**
+	 * Returns the number of puzzles in a tier.
+	 */
+	unsigned long Pool::size(tDifficulty difficulty) const {
+		return Rings[difficulty]->size();
+	}
+
+	/**
+	 * Writes the puzzles of the pool to a file, one per line: the tier number, the puzzle and its
+	 * solution, separated by spaces. The puzzles stay in the pool while they're written, so the
+	 * threads keep generating and taking them; the ones taken meanwhile may be missing in the file.
+	 * \arg		path	file to write
+	 * \return	false if it couldn't be written
+	 */
+	bool Pool::save(const char* path) {
+		FILE* file = fopen(path, "w");
+		bool ok = file != 0;
+
+		for(short unsigned int t = 0; t < 4 && ok; t++) {
+			vector<Entry> entries(Rings[t]->capacity());
+			unsigned long n = Rings[t]->peek(&entries[0], entries.size());
+
+			for(unsigned long i = 0; i < n && ok; i++)
+				ok = fprintf(file, "%u %.81s %.81s\n", t, entries[i].Puzzle, entries[i].Solution) == 166;
+		}
+
+		if(file != 0 && fclose(file) != 0)
+			ok = false;
+
+		return ok;
+	}
+
+	/**
+	 * Adds to the pool the puzzles of a file written by save(). Lines which aren't well formed
+	 * are skipped, as well as the puzzles which don't fit in their tier.
+	 * \arg		path	file to read
+	 * \return	false if it couldn't be read
+	 */
+	bool Pool::load(const char* path) {
+		FILE* file = fopen(path, "r");
+		char line[256];
+
+		if(file == 0)
+			return false;
+
+		while(fgets(line, sizeof(line), file) != 0) {
+			Entry entry;
+
+			if(strlen(line) < 166 || line[0] < '0' || line[0] > '3' || line[1] != ' ' || line[83] != ' ')
+				continue;
+
+			memcpy(entry.Puzzle, line + 2, 81);
+			memcpy(entry.Solution, line + 84, 81);
+			Rings[line[0] - '0']->push(entry);
+		}
+
+		fclose(file);
+		return true;
+	}
+}
+}
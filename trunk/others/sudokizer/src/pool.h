@@ -0,0 +1,98 @@
+// See COPYING file for licensing information.
+/**
+ * \file pool.h
+ * Definition of the pool of puzzles generated in the background, by difficulty.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "sudoku.h"
+#include "hint.h"
+#include <pthread.h>
+
+namespace std {
+namespace sudoku {
+	class TranspositionTable;
+
+	/**
+	 * Difficulty tiers of the pool, given by the hardest technique the Hinter needs:
+	 * - easy: naked and hidden singles
+	 * - medium: locked candidates
+	 * - hard: naked and hidden pairs, x-wings
+	 * - expert: none of the Hinter techniques is enough
+	 */
+	typedef enum{easy,medium,hard,expert} tDifficulty;
+
+	/** A puzzle and its solution, as 81 characters each: '1' to '9', and '.' for the empty cells */
+	typedef struct {
+		char Puzzle[81];
+		char Solution[81];
+	} Entry;
+
+	/**
+	 * Bounded queue of entries which any number of threads can push to and pop from without
+	 * locking. Each slot has a sequence number telling whether it's ready to be written or read
+	 * at a given position, so a thread only has to win a compare and swap on the head or the tail.
+	 */
+	class Ring {
+		struct Slot {
+			volatile unsigned long Sequence;
+			Entry Data;
+		};
+
+		Slot* Slots;
+		unsigned long Mask;
+		volatile unsigned long Head;
+		char Padding[64];
+		volatile unsigned long Tail;
+
+		Ring(const Ring& copy);
+	public:
+		Ring(unsigned long capacity);
+		~Ring();
+
+		bool push(const Entry& entry);
+		bool pop(Entry& entry);
+		unsigned long peek(Entry* entries, unsigned long count) const;
+		unsigned long size() const;
+		unsigned long capacity() const;
+	};
+
+	/**
+	 * Pool of unique puzzles by difficulty tier, kept topped up by background threads.
+	 * The threads generate while some tier is below its low watermark, digging puzzles straight
+	 * into the band of the tier which needs them most, and only keep puzzles for the tiers below
+	 * their high watermark. Taking a puzzle never locks nor waits: it fails
+	 * at once if the tier is empty. The pool can be saved to a file and loaded back.
+	 */
+	class Pool {
+		Ring* Rings[4];
+		unsigned long Low[4], High[4];
+		pthread_t* Threads;
+		short unsigned int Running;
+		volatile int Stop;
+
+		Pool(const Pool& copy);
+
+		static void* worker(void* pool);
+		static tDifficulty tier(tTechnique hardest);
+		bool hungry() const;
+		tDifficulty neediest() const;
+		void produce(unsigned int& seed, TranspositionTable& table);
+	public:
+		Pool(unsigned long capacity = 1024);
+		~Pool();
+
+		void setWatermarks(tDifficulty difficulty, unsigned long low, unsigned long high);
+		bool start(short unsigned int threads = 1);
+		void stop();
+		bool take(tDifficulty difficulty, Entry& entry);
+		bool put(tDifficulty difficulty, const Entry& entry);
+		unsigned long size(tDifficulty difficulty) const;
+		bool save(const char* path);
+		bool load(const char* path);
+	};
+}
+}
+#endif
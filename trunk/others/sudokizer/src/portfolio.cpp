@@ -0,0 +1,243 @@
+// See COPYING file for licensing information.
+/**
+ * \file portfolio.cpp
+ * Implementation of the race of several engines on the same board.
+ */
+#include "portfolio.h"
+#include "search.h"
+#include "backjump.h"
+#include "sat.h"
+#include "trace.h"
+#include <sys/time.h>
+#include <cerrno>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * State shared by the engines of a race.
+	 */
+	class RaceJob {
+	public:
+		Board& Source;
+		Grid Start;
+		volatile int Cancel;	// set once the race is over, cancelling the engines still running
+
+		pthread_mutex_t Lock;
+		pthread_cond_t Over;
+		short unsigned int Running;
+		bool Finished, Solved;
+		tEngine Winner;
+		Grid Solution;
+
+		RaceJob(Board& Sudoku, const Grid& start)
+			: Source(Sudoku), Start(start), Cancel(0), Running(0), Finished(false), Solved(false), Winner(noEngine)
+		{
+			pthread_mutex_init(&Lock, 0);
+			pthread_cond_init(&Over, 0);
+		}
+
+		~RaceJob() {
+			pthread_cond_destroy(&Over);
+			pthread_mutex_destroy(&Lock);
+		}
+	};
+
+	/**
+	 * An engine of a race, given to its thread.
+	 */
+	typedef struct {
+		RaceJob* Job;
+		tEngine Engine;
+	} Racer;
+
+	/**
+	 * Body of the thread of an engine: runs it and, if it ends the race, keeps its result.
+	 * \arg		racer	the Racer
+	 */
+	void* Portfolio::racer(void* racer) {
+		RaceJob& Job = *static_cast<Racer*>(racer)->Job;
+		tEngine engine = static_cast<Racer*>(racer)->Engine;
+		Budget budget(0, 0, &Job.Cancel);
+		Grid grid = Job.Start;
+		bool solved = false, decided;
+
+		if(engine == logicEngine || engine == satEngine) {
+			Board Sudoku(Job.Source);
+
+			try {
+				if(engine == logicEngine)
+					solved = Solver::resolve(Sudoku, budget) && Sudoku.getState() == definitive;
+				else
+					solved = SatSolver::solve(Sudoku, budget);
+				decided = solved || (engine == satEngine && !budget.exceeded());
+			} catch(logic_error&) {
+				// The propagation only fails on boards without solution
+				decided = true;
+			}
+
+			if(solved)
+				solved = grid.load(Sudoku);
+		} else {
+			if(engine == searchEngine)
+				solved = Search::solve(grid, budget);
+			else
+				solved = Backjumper::solve(grid, budget);
+			decided = solved || !budget.exceeded();
+		}
+
+		pthread_mutex_lock(&Job.Lock);
+		if(decided && !Job.Finished) {
+			Job.Finished = true;
+			Job.Solved = solved;
+			Job.Winner = engine;
+			Job.Solution = grid;
+			Job.Cancel = 1;
+		}
+		Job.Running--;
+		pthread_cond_signal(&Job.Over);
+		pthread_mutex_unlock(&Job.Lock);
+
+		return 0;
+	}
+
+	/**
+	 * Portfolio constructor.
+	 * \arg		width	number of engines run in each race, the ones which won most so far
+	 */
+	Portfolio::Portfolio(short unsigned int width)
+		: Races(0), Width(width > 0 && width < noEngine ? width : static_cast<short unsigned int>(noEngine))
+	{
+		for(short unsigned int e = 0; e < noEngine; e++)
+			Wins[e] = 0;
+	}
+
+	/**
+	 * Solves a sudoku board, which is left with the solution if there's any.
+	 * \arg		Sudoku	board to solve
+	 * \return	true if the board has a solution
+	 */
+	bool Portfolio::solve(Board& Sudoku) {
+		Budget unlimited;
+
+		return solve(Sudoku, unlimited);
+	}
+
+	/**
+	 * Solves a sudoku board within a budget, racing the engines, and leaves it with the solution
+	 * if one was found. The calling thread only waits for the engines, checking the deadline and
+	 * the cancel flag of the budget meanwhile; every engine has its own count of nodes.
+	 * \arg		Sudoku	board to solve
+	 * \arg		budget	limits of the race
+	 * \arg		winner	set to the engine which ended the race, or noEngine, unless it's 0
+	 * \return	true if a solution was found; if not, budget.exceeded() tells whether the board has
+	 *			no solution or the race was stopped
+	 */
+	bool Portfolio::solve(Board& Sudoku, Budget& budget, tEngine* winner) {
+		SUDOKU_TRACE_SPAN("race");
+		tEngine engines[noEngine];
+		Racer racers[noEngine];
+		pthread_t threads[noEngine];
+		bool started[noEngine];
+		Grid grid;
+
+		if(winner != 0)
+			*winner = noEngine;
+
+		// A race is only watched every millisecond, so an exceeded budget mustn't let one start
+		if(!budget.poll() || !grid.load(Sudoku))
+			return false;
+
+		RaceJob job(Sudoku, grid);
+
+		// The logic engine is the only one which may get stuck, so it never races alone
+		order(engines);
+		if(Width == 1 && engines[0] == logicEngine) {
+			engines[0] = engines[1];
+			engines[1] = logicEngine;
+		}
+
+		pthread_mutex_lock(&job.Lock);
+		for(short unsigned int i = 0; i < Width; i++) {
+			racers[i].Job = &job;
+			racers[i].Engine = engines[i];
+			started[i] = pthread_create(&threads[i], 0, racer, &racers[i]) == 0;
+			if(started[i])
+				job.Running++;
+		}
+
+		while(!job.Finished && job.Running > 0) {
+			timeval now;
+			timespec wake;
+
+			gettimeofday(&now, 0);
+			wake.tv_sec = now.tv_sec;
+			wake.tv_nsec = now.tv_usec * 1000 + 1000000;
+			if(wake.tv_nsec >= 1000000000) {
+				wake.tv_sec++;
+				wake.tv_nsec -= 1000000000;
+			}
+
+			if(pthread_cond_timedwait(&job.Over, &job.Lock, &wake) == ETIMEDOUT && !budget.poll())
+				job.Cancel = 1;
+		}
+		pthread_mutex_unlock(&job.Lock);
+
+		for(short unsigned int i = 0; i < Width; i++)
+			if(started[i])
+				pthread_join(threads[i], 0);
+
+		if(job.Finished) {
+			__sync_add_and_fetch(&Wins[job.Winner], 1);
+			__sync_add_and_fetch(&Races, 1);
+			if(winner != 0)
+				*winner = job.Winner;
+		}
+
+		if(job.Solved)
+			job.Solution.store(Sudoku);
+
+		return job.Solved;
+	}
+
+	/**
+	 * Lists the engines from the one which won most races to the one which won least; engines
+	 * with as many wins keep the order of tEngine.
+	 * \arg		engines	array of noEngine engines to fill
+	 */
+	void Portfolio::order(tEngine* engines) const {
+		unsigned long wins[noEngine];
+
+		for(short unsigned int e = 0; e < noEngine; e++) {
+			short unsigned int i = e;
+
+			wins[e] = Wins[e];
+			for(; i > 0 && wins[engines[i - 1]] < wins[e]; i--)
+				engines[i] = engines[i - 1];
+			engines[i] = static_cast<tEngine>(e);
+		}
+	}
+
+	/**
+	 * Returns the number of races won by an engine.
+	 */
+	unsigned long Portfolio::getWins(tEngine engine) const {
+		return Wins[engine];
+	}
+
+	/**
+	 * Returns the number of races which some engine finished.
+	 */
+	unsigned long Portfolio::getRaces() const {
+		return Races;
+	}
+
+	/**
+	 * Returns the name of an engine, as given on the command line.
+	 */
+	const char* Portfolio::name(tEngine engine) {
+		static const char* names[] = {"logic", "search", "backjump", "sat", "none"};
+
+		return names[engine];
+	}
+}
+}
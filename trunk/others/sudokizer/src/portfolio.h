@@ -0,0 +1,55 @@
+// See COPYING file for licensing information.
+/**
+ * \file portfolio.h
+ * Definition of the race of several engines on the same board.
+ */
+
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "sudoku.h"
+#include "budget.h"
+#include <pthread.h>
+
+namespace std {
+namespace sudoku {
+	class RaceJob;
+
+	/**
+	 * Engines taking part in a race:
+	 * - logicEngine: the propagation of Solver::resolve, which may get stuck
+	 * - searchEngine: the backtracking search, branching on the cell with the fewest candidates
+	 * - backjumpEngine: the search with conflict-directed backjumping
+	 * - satEngine: the CDCL solver on the exact cover encoding of the board
+	 * - noEngine: none of them finished
+	 */
+	typedef enum{logicEngine,searchEngine,backjumpEngine,satEngine,noEngine} tEngine;
+
+	/**
+	 * Solves a board by running several engines at once, each one on its own thread and its own
+	 * copy of the board. The first engine to find the solution, or to prove there's none, wins the
+	 * race and the others are cancelled through their budgets. The wins of every engine are
+	 * counted, and when the portfolio runs fewer engines than it knows, it runs the ones which won
+	 * most so far; the logic engine, which may get stuck without deciding, is never run alone.
+	 */
+	class Portfolio {
+		volatile unsigned long Wins[noEngine];
+		volatile unsigned long Races;
+		short unsigned int Width;
+
+		Portfolio(const Portfolio& copy);
+
+		static void* racer(void* racer);
+	public:
+		Portfolio(short unsigned int width = noEngine);
+
+		bool solve(Board& Sudoku);
+		bool solve(Board& Sudoku, Budget& budget, tEngine* winner = 0);
+		void order(tEngine* engines) const;
+		unsigned long getWins(tEngine engine) const;
+		unsigned long getRaces() const;
+		static const char* name(tEngine engine);
+	};
+}
+}
+#endif
@@ -0,0 +1,261 @@
+// See COPYING file for licensing information.
+/**
+ * \file reducer.cpp
+ * Implementation of the removal of clues from a puzzle until it's minimal.
+ * Several threads test the clues at the same time against the latest puzzle they see. Finding a
+ * clue needed is always right, since the puzzle only loses clues; finding it removable is only
+ * right if no other clue was removed meanwhile, otherwise the clue is queued to be tested again.
+ */
+#include "reducer.h"
+#include "trace.h"
+#include <deque>
+#include <sched.h>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * State shared by the threads reducing a puzzle, always accessed with its Lock held.
+	 */
+	class ReduceJob {
+	public:
+		short unsigned int Values[81];	// the puzzle being reduced, 0 for the empty cells
+		bool Needed[81];				// clues known to be needed
+		Grid Base;						// the needed clues, already assigned
+		unsigned long Version;			// number of clues removed so far
+		deque<short unsigned int> Pending;	// clues to test
+		short unsigned int Testing;		// clues being tested
+		Budget& Limits;					// budget of the call
+		volatile int Stop;				// set once the budget is exceeded, to cancel the tests
+
+		pthread_mutex_t Lock;
+
+		ReduceJob(Budget& budget)
+			: Version(0), Testing(0), Limits(budget), Stop(0)
+		{
+			pthread_mutex_init(&Lock, 0);
+		}
+
+		~ReduceJob() {
+			pthread_mutex_destroy(&Lock);
+		}
+	};
+
+	/**
+	 * States if a clue can be removed from a puzzle without making it ambiguous.
+	 * \arg		base	the needed clues of the puzzle, already assigned
+	 * \arg		values	the puzzle
+	 * \arg		needed	whether each clue is already assigned in base
+	 * \arg		clue	index of the clue to test
+	 * \arg		budget	limits of the search
+	 * \return	true if the puzzle without the clue has no solution with another value there; false
+	 *			too if budget.exceeded()
+	 */
+	bool Reducer::removable(const Grid& base, const short unsigned int* values, const bool* needed,
+		short unsigned int clue, Budget& budget)
+	{
+		SUDOKU_TRACE_SPAN("clue test");
+		Grid grid = base;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(c != clue && values[c] != 0 && !needed[c] && !grid.assign(c, values[c]))
+				return true;
+
+		if(!grid.eliminate(clue, values[clue]))
+			return true;
+
+		return !Search::solve(grid, budget) && !budget.exceeded();
+	}
+
+	/**
+	 * Body of a reducing thread: tests clues until none is pending nor being tested, or until the
+	 * budget is exceeded.
+	 * \arg		job		the ReduceJob
+	 */
+	void* Reducer::worker(void* job) {
+		ReduceJob& Job = *static_cast<ReduceJob*>(job);
+		short unsigned int values[81];
+		bool needed[81];
+		Grid base;
+
+		for(;;) {
+			pthread_mutex_lock(&Job.Lock);
+
+			if(Job.Stop || Job.Pending.empty()) {
+				bool done = (Job.Stop || Job.Testing == 0);
+
+				pthread_mutex_unlock(&Job.Lock);
+				if(done)
+					break;
+
+				// A clue being tested elsewhere may be queued again
+				sched_yield();
+				continue;
+			}
+
+			// The lock makes the budget safe to spend from any thread
+			if(!Job.Limits.poll() || !Job.Limits.spend()) {
+				Job.Stop = 1;
+				pthread_mutex_unlock(&Job.Lock);
+				break;
+			}
+
+			short unsigned int clue = Job.Pending.front();
+			unsigned long version = Job.Version;
+
+			Job.Pending.pop_front();
+			Job.Testing++;
+			for(short unsigned int c = 0; c < 81; c++) {
+				values[c] = Job.Values[c];
+				needed[c] = Job.Needed[c];
+			}
+			base = Job.Base;
+
+			pthread_mutex_unlock(&Job.Lock);
+
+			Budget budget(0, 0, &Job.Stop);
+			bool remove = removable(base, values, needed, clue, budget);
+
+			pthread_mutex_lock(&Job.Lock);
+
+			// A cancelled test tells nothing
+			if(budget.exceeded())
+				Job.Pending.push_back(clue);
+			else if(!remove) {
+				Job.Needed[clue] = true;
+				Job.Base.assign(clue, Job.Values[clue]);
+			} else if(version == Job.Version) {
+				Job.Values[clue] = 0;
+				Job.Version++;
+			} else
+				Job.Pending.push_back(clue);
+			Job.Testing--;
+
+			pthread_mutex_unlock(&Job.Lock);
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Removes clues from a puzzle until it's minimal. The clues are tried in random order, so
+	 * successive calls on the same puzzle may give different minimal puzzles.
+	 * \arg		values	the 81 cells of the puzzle, row by row, 0 for the empty ones; the removed
+	 *					clues are set to 0
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	the number of clues left, or 0 if the puzzle hasn't a unique solution, in which case
+	 *			it's left unchanged
+	 */
+	short unsigned int Reducer::reduce(short unsigned int* values, short unsigned int threads) {
+		Budget unlimited;
+
+		return reduce(values, unlimited, threads);
+	}
+
+	/**
+	 * Removes clues from a board until it's minimal. The definitive cells are taken as the clues,
+	 * and the removed ones are made undecided again; the possibilities are then rebuilt as with
+	 * Board::recount.
+	 * \arg		Sudoku	the board to reduce
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	the number of clues left, or 0 if the board hasn't a unique solution, in which case
+	 *			it's left unchanged
+	 */
+	short unsigned int Reducer::reduce(Board& Sudoku, short unsigned int threads) {
+		Budget unlimited;
+
+		return reduce(Sudoku, unlimited, threads);
+	}
+
+	/**
+	 * Removes clues from a puzzle within a budget, until it's minimal or the budget is exceeded.
+	 * \arg		values	the 81 cells of the puzzle, row by row, 0 for the empty ones; the removed
+	 *					clues are set to 0
+	 * \arg		budget	limits of the call, spending a node per branch of the check that the
+	 *					solution is unique and per clue tested
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	the number of clues left, or 0 if the puzzle hasn't a unique solution or the budget
+	 *			was exceeded before that was known, in which case it's left unchanged; if
+	 *			budget.exceeded() the puzzle left may not be minimal
+	 */
+	short unsigned int Reducer::reduce(short unsigned int* values, Budget& budget, short unsigned int threads) {
+		ReduceJob job(budget);
+		Grid grid;
+		short unsigned int clues[81], n = 0;
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			job.Values[c] = values[c];
+			job.Needed[c] = false;
+			if(values[c] != 0) {
+				if(!grid.assign(c, values[c]))
+					return 0;
+				clues[n++] = c;
+			}
+		}
+
+		if(Search::count(grid, budget, 2) != 1 || budget.exceeded())
+			return 0;
+
+		for(short unsigned int i = n; i > 1; i--) {
+			short unsigned int j = Generator::nextValue(i, 0), clue = clues[i - 1];
+
+			clues[i - 1] = clues[j];
+			clues[j] = clue;
+		}
+		for(short unsigned int i = 0; i < n; i++)
+			job.Pending.push_back(clues[i]);
+
+		if(threads == 0)
+			threads = Search::cores();
+
+		pthread_t* others = new pthread_t[threads];
+		short unsigned int started = 1;
+
+		for(; started < threads; started++)
+			if(pthread_create(&others[started], 0, worker, &job) != 0)
+				break;
+
+		worker(&job);
+
+		for(short unsigned int i = 1; i < started; i++)
+			pthread_join(others[i], 0);
+
+		delete[] others;
+
+		n = 0;
+		for(short unsigned int c = 0; c < 81; c++) {
+			values[c] = job.Values[c];
+			if(values[c] != 0)
+				n++;
+		}
+
+		return n;
+	}
+
+	/**
+	 * Removes clues from a board within a budget, until it's minimal or the budget is exceeded.
+	 * \arg		Sudoku	the board to reduce
+	 * \arg		budget	limits of the call, as for the reduction of a puzzle
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	the number of clues left, or 0 if the board hasn't a unique solution or the budget
+	 *			was exceeded before that was known, in which case it's left unchanged; if
+	 *			budget.exceeded() the board left may not be minimal
+	 */
+	short unsigned int Reducer::reduce(Board& Sudoku, Budget& budget, short unsigned int threads) {
+		short unsigned int values[81], n;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			values[c] = (Sudoku.Cells[c]->State == definitive) ? Sudoku.Cells[c]->Possibilities[0] : 0;
+
+		n = reduce(values, budget, threads);
+		if(n == 0)
+			return 0;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(values[c] == 0)
+				Sudoku.Cells[c]->State = undecided;
+		Sudoku.recount();
+
+		return n;
+	}
+}
+}
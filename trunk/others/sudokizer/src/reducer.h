@@ -0,0 +1,43 @@
+// See COPYING file for licensing information.
+/**
+ * \file reducer.h
+ * Definition of the removal of clues from a puzzle until it's minimal.
+ */
+
+#ifndef REDUCER_H
+#define REDUCER_H
+
+#include "sudoku.h"
+#include "search.h"
+
+namespace std {
+namespace sudoku {
+	class ReduceJob;
+
+	/**
+	 * Removes clues from a puzzle with a unique solution until every remaining clue is needed for
+	 * the solution to be unique.
+	 * A clue can go if the puzzle without it has no solution with another value in its cell, which
+	 * is a search for one solution instead of a count up to two. A clue which can't go is needed in
+	 * any puzzle made of fewer clues too, so every clue is tested only once, unless another one was
+	 * removed while it was being tested and it looked removable; and the needed clues are assigned
+	 * once in a Grid shared by all the later tests.
+	 * Within a budget, a node is spent per clue tested and the clock and the cancel flag are read
+	 * before each test; once it's exceeded, the clues removed so far are kept, which leaves a
+	 * puzzle with the same unique solution, only not minimal.
+	 */
+	class Reducer {
+		Reducer();
+
+		static bool removable(const Grid& base, const short unsigned int* values, const bool* needed,
+			short unsigned int clue, Budget& budget);
+		static void* worker(void* job);
+	public:
+		static short unsigned int reduce(short unsigned int* values, short unsigned int threads = 1);
+		static short unsigned int reduce(Board& Sudoku, short unsigned int threads = 1);
+		static short unsigned int reduce(short unsigned int* values, Budget& budget, short unsigned int threads = 1);
+		static short unsigned int reduce(Board& Sudoku, Budget& budget, short unsigned int threads = 1);
+	};
+}
+}
+#endif
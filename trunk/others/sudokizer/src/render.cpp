@@ -0,0 +1,225 @@
+// See COPYING file for licensing information.
+/**
+ * \file render.cpp
+ * Implementation of the formatting of sudoku boards into text.
+ * Boards are formatted into a buffer given by the caller, which can hold many boards, so that
+ * they can be written with a single system call.
+ */
+#include "render.h"
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Appends a string to the buffer, moving the buffer pointer past it.
+	 */
+	static inline void append(char*& out, const char* text, size_t length) {
+		memcpy(out, text, length);
+		out += length;
+	}
+
+	/**
+	 * Returns the maximum number of bytes a board can take in the given format.
+	 * \arg		Format	text format
+	 */
+	size_t Render::size(tFormat Format) {
+		switch(Format) {
+			case oneline:
+				return 82;
+			case pretty:
+				return 1024;
+			case json:
+				return 1200;
+			case pencil:
+				return 1200;
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Formats a board given by the definitive value (or 0) and the candidates bitmask of each cell.
+	 * \arg		values		definitive values of the 81 cells, row by row
+	 * \arg		candidates	candidates bitmask of the 81 cells, row by row
+	 * \arg		Format		text format
+	 * \arg		buffer		where the text is written; it's not '\\0' terminated
+	 * \arg		length		size of the buffer
+	 * \return	number of bytes written, or 0 if the buffer is smaller than size(Format)
+	 */
+	size_t Render::format(const short unsigned int* values, const short unsigned int* candidates,
+		tFormat Format, char* buffer, size_t length)
+	{
+		static const char header[] = "y\\x|| 1 | 2 | 3 || 4 | 5 | 6 || 7 | 8 | 9 ||\n",
+			lineSeparator1[] = "---||---|---|---||---|---|---||---|---|---||\n",
+			lineSeparator2[] = "===||###|###|###||###|###|###||###|###|###||\n",
+			pencilSeparator[] = "------------+-------------+------------\n";
+
+		if(length < size(Format))
+			return 0;
+
+		char* out = buffer;
+
+		switch(Format) {
+			case oneline:
+				for(short unsigned int c = 0; c < 81; c++)
+					*out++ = values[c] ? '0' + values[c] : '.';
+				*out++ = '\n';
+				break;
+
+			case pretty:
+				append(out, header, sizeof(header) - 1);
+				append(out, lineSeparator2, sizeof(lineSeparator2) - 1);
+
+				for(short unsigned int i = 0; i < 9; i++) {
+					*out++ = ' ';
+					*out++ = '1' + i;
+					append(out, " || ", 4);
+
+					for(short unsigned int j = 0; j < 9; j++) {
+						*out++ = values[i * 9 + j] ? '0' + values[i * 9 + j] : ' ';
+
+						if((j + 1) % 3 == 0)
+							append(out, " || ", 4);
+						else
+							append(out, " | ", 3);
+					}
+
+					*out++ = '\n';
+					if((i + 1) % 3 == 0)
+						append(out, lineSeparator2, sizeof(lineSeparator2) - 1);
+					else
+						append(out, lineSeparator1, sizeof(lineSeparator1) - 1);
+				}
+				break;
+
+			case json: {
+				bool solved = true;
+
+				append(out, "{\"grid\":\"", 9);
+				for(short unsigned int c = 0; c < 81; c++) {
+					*out++ = values[c] ? '0' + values[c] : '.';
+					solved = solved && values[c];
+				}
+
+				if(solved)
+					append(out, "\",\"solved\":true,\"candidates\":[", 30);
+				else
+					append(out, "\",\"solved\":false,\"candidates\":[", 31);
+
+				for(short unsigned int c = 0; c < 81; c++) {
+					if(c > 0)
+						*out++ = ',';
+					*out++ = '"';
+					for(short unsigned int p = 1; !values[c] && p < 10; p++)
+						if(candidates[c] & (1 << (p - 1)))
+							*out++ = '0' + p;
+					*out++ = '"';
+				}
+
+				append(out, "]}\n", 3);
+				break;
+			}
+
+			case pencil:
+				// Each row of cells takes three lines, each cell showing three of its candidates per line
+				for(short unsigned int i = 0; i < 9; i++) {
+					if(i == 3 || i == 6)
+						append(out, pencilSeparator, sizeof(pencilSeparator) - 1);
+
+					for(short unsigned int line = 0; line < 3; line++) {
+						for(short unsigned int j = 0; j < 9; j++) {
+							short unsigned int c = i * 9 + j;
+
+							if(j == 3 || j == 6)
+								append(out, " | ", 3);
+							else if(j > 0)
+								*out++ = ' ';
+
+							for(short unsigned int k = 0; k < 3; k++) {
+								short unsigned int p = line * 3 + k + 1;
+
+								if(values[c])
+									*out++ = (p == 5) ? '0' + values[c] : ' ';
+								else
+									*out++ = (candidates[c] & (1 << (p - 1))) ? '0' + p : '.';
+							}
+						}
+						*out++ = '\n';
+					}
+				}
+				break;
+		}
+
+		return out - buffer;
+	}
+
+	/**
+	 * Formats a sudoku board.
+	 * Undecided cells show the possibilities still listed in the Board as candidates.
+	 * \arg		Sudoku	board to format
+	 * \arg		Format	text format
+	 * \arg		buffer	where the text is written; it's not '\\0' terminated
+	 * \arg		length	size of the buffer
+	 * \return	number of bytes written, or 0 if the buffer is smaller than size(Format)
+	 */
+	size_t Render::format(Board& Sudoku, tFormat Format, char* buffer, size_t length) {
+		short unsigned int values[81], candidates[81];
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			Cell& cell = *Sudoku.Cells[c];
+
+			values[c] = (cell.State == definitive) ? cell.Possibilities[0] : 0;
+			candidates[c] = 0;
+			for(short unsigned int i = 0; i < 9 && cell.Possibilities[i] != 0; i++)
+				candidates[c] |= 1 << (cell.Possibilities[i] - 1);
+		}
+
+		return format(values, candidates, Format, buffer, length);
+	}
+
+	/**
+	 * Formats the state of a search Grid.
+	 * \arg		grid	state to format
+	 * \arg		Format	text format
+	 * \arg		buffer	where the text is written; it's not '\\0' terminated
+	 * \arg		length	size of the buffer
+	 * \return	number of bytes written, or 0 if the buffer is smaller than size(Format)
+	 */
+	size_t Render::format(const Grid& grid, tFormat Format, char* buffer, size_t length) {
+		short unsigned int values[81], candidates[81];
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			values[c] = grid.get(c);
+			candidates[c] = grid.getCandidates(c);
+		}
+
+		return format(values, candidates, Format, buffer, length);
+	}
+
+	/**
+	 * Writes a formatted buffer to a file descriptor, retrying after partial writes.
+	 * \arg		fd		file descriptor, like 1 for the standard output
+	 * \arg		buffer	text to write
+	 * \arg		length	number of bytes to write
+	 * \return	false if the text couldn't be written
+	 */
+	bool Render::emit(int fd, const char* buffer, size_t length) {
+		while(length > 0) {
+			ssize_t written = write(fd, buffer, length);
+
+			if(written < 0) {
+				if(errno == EINTR)
+					continue;
+				return false;
+			}
+
+			buffer += written;
+			length -= written;
+		}
+
+		return true;
+	}
+}
+}
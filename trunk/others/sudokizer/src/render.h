@@ -0,0 +1,37 @@
+// See COPYING file for licensing information.
+/**
+ * \file render.h
+ * Definition of the formatting of sudoku boards into text.
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "sudoku.h"
+#include "search.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Text formats of a board:
+	 * - oneline: the 81 cells row by row, '.' for the undecided ones, and a new line
+	 * - pretty: the grid with its coordinates, as it's shown by Display::show
+	 * - json: an object with the grid as in oneline, whether it's solved, and the candidates of each cell
+	 * - pencil: each cell drawn as a 3x3 square with its candidates, as pencil marks on paper
+	 */
+	typedef enum{oneline,pretty,json,pencil} tFormat;
+
+	class Render {
+		Render();
+
+		static size_t format(const short unsigned int* values, const short unsigned int* candidates,
+			tFormat Format, char* buffer, size_t length);
+	public:
+		static size_t size(tFormat Format);
+		static size_t format(Board& Sudoku, tFormat Format, char* buffer, size_t length);
+		static size_t format(const Grid& grid, tFormat Format, char* buffer, size_t length);
+		static bool emit(int fd, const char* buffer, size_t length);
+	};
+}
+}
+#endif
@@ -0,0 +1,714 @@
+// See COPYING file for licensing information.
+/**
+ * \file sat.cpp
+ * Implementation of the CDCL satisfiability solver and of the engine solving sudoku boards with it.
+ */
+#include "sat.h"
+#include "tables.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Returns the y^k factor of the k-th restart of the Luby sequence: 1 1 2 1 1 2 4 1 1 2 ...
+	 */
+	static double luby(double y, unsigned long x) {
+		unsigned long size = 1, seq = 0;
+		double factor = 1;
+
+		while(size < x + 1) {
+			seq++;
+			size = 2 * size + 1;
+		}
+
+		while(size - 1 != x) {
+			size = (size - 1) >> 1;
+			seq--;
+			x = x % size;
+		}
+
+		while(seq-- > 0)
+			factor *= y;
+
+		return factor;
+	}
+
+	/**
+	 * Orders learnt clauses by activity, the least active first.
+	 */
+	struct LessActive {
+		template<class T> bool operator()(const T* a, const T* b) const {
+			return a->Lits.size() > 2 && (b->Lits.size() == 2 || a->Activity < b->Activity);
+		}
+	};
+
+	/**
+	 * Sat constructor.
+	 */
+	Sat::Sat()
+		: VarInc(1), ClauseInc(1), QHead(0), Ok(true), Conflicts(0)
+	{
+	}
+
+	/**
+	 * Sat destructor.
+	 */
+	Sat::~Sat() {
+		for(size_t i = 0; i < Clauses.size(); i++)
+			delete Clauses[i];
+		for(size_t i = 0; i < Learnts.size(); i++)
+			delete Learnts[i];
+	}
+
+	/**
+	 * Returns the literal of a variable.
+	 * \arg		var			variable index
+	 * \arg		positive	true for the literal stating that the variable is true
+	 */
+	int Sat::lit(int var, bool positive) {
+		return 2 * var + (positive ? 0 : 1);
+	}
+
+	/**
+	 * Adds a new variable.
+	 * \return	its index
+	 */
+	int Sat::newVariable() {
+		int var = Assigns.size();
+
+		Assigns.push_back(-1);
+		Polarity.push_back(1);
+		Level.push_back(0);
+		Reason.push_back(0);
+		Activity.push_back(0);
+		Seen.push_back(0);
+		HeapIndex.push_back(-1);
+		Watches.push_back(vector<Clause*>());
+		Watches.push_back(vector<Clause*>());
+		heapInsert(var);
+
+		return var;
+	}
+
+	/**
+	 * Returns the number of variables.
+	 */
+	int Sat::variables() const {
+		return Assigns.size();
+	}
+
+	/**
+	 * Returns 1 if a literal is true, 0 if it's false or -1 if its variable is unassigned.
+	 */
+	inline signed char Sat::value(int lit) const {
+		signed char v = Assigns[lit >> 1];
+
+		return v < 0 ? v : v ^ (lit & 1);
+	}
+
+	/**
+	 * Makes a literal true.
+	 * \arg		lit		the literal
+	 * \arg		reason	clause that implied it, or 0 for a decision
+	 */
+	void Sat::enqueue(int lit, Clause* reason) {
+		int var = lit >> 1;
+
+		Assigns[var] = !(lit & 1);
+		Level[var] = TrailLim.size();
+		Reason[var] = reason;
+		Trail.push_back(lit);
+	}
+
+	/**
+	 * Starts watching the first two literals of a clause.
+	 */
+	void Sat::attach(Clause* clause) {
+		Watches[clause->Lits[0]].push_back(clause);
+		Watches[clause->Lits[1]].push_back(clause);
+	}
+
+	/**
+	 * Adds a problem clause. Must be called before solve().
+	 * \arg		lits	literals of the clause
+	 * \return	false if the problem became trivially unsatisfiable
+	 */
+	bool Sat::addClause(const vector<int>& lits) {
+		if(!Ok)
+			return false;
+
+		vector<int> clause;
+
+		// Drop false and repeated literals, and satisfied or tautological clauses
+		for(size_t i = 0; i < lits.size(); i++) {
+			signed char v = value(lits[i]);
+
+			if(v == 1 || find(clause.begin(), clause.end(), lits[i] ^ 1) != clause.end())
+				return true;
+			else if(v == -1 && find(clause.begin(), clause.end(), lits[i]) == clause.end())
+				clause.push_back(lits[i]);
+		}
+
+		if(clause.empty()) {
+			Ok = false;
+		} else if(clause.size() == 1) {
+			enqueue(clause[0], 0);
+			Ok = (propagate() == 0);
+		} else {
+			Clause* c = new Clause();
+			c->Lits = clause;
+			c->Learnt = false;
+			c->Deleted = false;
+			c->Activity = 0;
+			Clauses.push_back(c);
+			attach(c);
+		}
+
+		return Ok;
+	}
+
+	/**
+	 * Propagates every literal assigned since the last call.
+	 * \return	the clause left with all its literals false, or 0 if there was no conflict
+	 */
+	Sat::Clause* Sat::propagate() {
+		while(QHead < Trail.size()) {
+			int falseLit = Trail[QHead++] ^ 1;
+			vector<Clause*>& watches = Watches[falseLit];
+			size_t i = 0, j = 0;
+
+			while(i < watches.size()) {
+				Clause* c = watches[i++];
+				vector<int>& lits = c->Lits;
+
+				// Make sure the false literal is the second watched one
+				if(lits[0] == falseLit)
+					swap(lits[0], lits[1]);
+
+				if(value(lits[0]) == 1) {
+					watches[j++] = c;
+					continue;
+				}
+
+				// Look for a new literal to watch
+				bool moved = false;
+
+				for(size_t k = 2; k < lits.size(); k++) {
+					if(value(lits[k]) != 0) {
+						swap(lits[1], lits[k]);
+						Watches[lits[1]].push_back(c);
+						moved = true;
+						break;
+					}
+				}
+
+				if(moved)
+					continue;
+
+				watches[j++] = c;
+
+				if(value(lits[0]) == 0) {
+					while(i < watches.size())
+						watches[j++] = watches[i++];
+					watches.resize(j);
+					QHead = Trail.size();
+					return c;
+				}
+
+				enqueue(lits[0], c);
+			}
+
+			watches.resize(j);
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Derives the first UIP clause of a conflict.
+	 * \arg		conflict		clause with all its literals false
+	 * \arg		learnt			where the learnt clause is stored, its asserting literal first
+	 * \arg		backtrackLevel	where the level to jump back to is stored
+	 */
+	void Sat::analyze(Clause* conflict, vector<int>& learnt, int& backtrackLevel) {
+		int pending = 0, p = -1, index = Trail.size() - 1, current = TrailLim.size();
+
+		learnt.clear();
+		learnt.push_back(-1);
+
+		do {
+			if(conflict->Learnt)
+				bumpClause(conflict);
+
+			for(size_t i = (p == -1) ? 0 : 1; i < conflict->Lits.size(); i++) {
+				int q = conflict->Lits[i], var = q >> 1;
+
+				if(!Seen[var] && Level[var] > 0) {
+					bumpVariable(var);
+					Seen[var] = 1;
+
+					if(Level[var] >= current)
+						pending++;
+					else
+						learnt.push_back(q);
+				}
+			}
+
+			// Next literal of the current level to look at
+			while(!Seen[Trail[index--] >> 1]);
+
+			p = Trail[index + 1];
+			conflict = Reason[p >> 1];
+			Seen[p >> 1] = 0;
+			pending--;
+		} while(pending > 0);
+
+		learnt[0] = p ^ 1;
+
+		// Jump back to the highest level among the rest of the literals, kept second
+		backtrackLevel = 0;
+		for(size_t i = 1; i < learnt.size(); i++) {
+			if(Level[learnt[i] >> 1] > backtrackLevel) {
+				backtrackLevel = Level[learnt[i] >> 1];
+				swap(learnt[1], learnt[i]);
+			}
+		}
+
+		for(size_t i = 1; i < learnt.size(); i++)
+			Seen[learnt[i] >> 1] = 0;
+	}
+
+	/**
+	 * Undoes every assignment made above the given decision level.
+	 */
+	void Sat::cancelUntil(int level) {
+		if((int)TrailLim.size() <= level)
+			return;
+
+		for(int i = Trail.size() - 1; i >= TrailLim[level]; i--) {
+			int var = Trail[i] >> 1;
+
+			Polarity[var] = Trail[i] & 1;
+			Assigns[var] = -1;
+			Reason[var] = 0;
+			if(HeapIndex[var] < 0)
+				heapInsert(var);
+		}
+
+		Trail.resize(TrailLim[level]);
+		TrailLim.resize(level);
+		QHead = Trail.size();
+	}
+
+	/**
+	 * Returns true if a clause is the reason of a current assignment, and so can't be deleted.
+	 */
+	bool Sat::locked(const Clause* clause) const {
+		int var = clause->Lits[0] >> 1;
+
+		return Reason[var] == clause && value(clause->Lits[0]) == 1;
+	}
+
+	/**
+	 * Deletes half of the learnt clauses, the least active ones, keeping binary and locked clauses.
+	 */
+	void Sat::reduce() {
+		sort(Learnts.begin(), Learnts.end(), LessActive());
+
+		vector<Clause*> alive, dead;
+		size_t half = Learnts.size() / 2;
+
+		for(size_t i = 0; i < Learnts.size(); i++) {
+			Clause* c = Learnts[i];
+
+			if(i < half && c->Lits.size() > 2 && !locked(c)) {
+				c->Deleted = true;
+				dead.push_back(c);
+			} else {
+				alive.push_back(c);
+			}
+		}
+
+		for(size_t l = 0; l < Watches.size(); l++) {
+			vector<Clause*>& watches = Watches[l];
+			size_t j = 0;
+
+			for(size_t i = 0; i < watches.size(); i++)
+				if(!watches[i]->Deleted)
+					watches[j++] = watches[i];
+			watches.resize(j);
+		}
+
+		for(size_t i = 0; i < dead.size(); i++)
+			delete dead[i];
+
+		Learnts.swap(alive);
+	}
+
+	/**
+	 * Picks the unassigned variable with the highest activity, with its saved phase.
+	 * \return	the literal to decide, or -1 if every variable is assigned
+	 */
+	int Sat::pickBranch() {
+		while(!Heap.empty()) {
+			int var = heapPop();
+
+			if(Assigns[var] < 0)
+				return lit(var, !Polarity[var]);
+		}
+
+		return -1;
+	}
+
+	/**
+	 * Searches for a model till a number of conflicts is reached.
+	 * \arg		conflicts	conflicts allowed before restarting
+	 * \arg		budget		limits of the search, spending a node per conflict
+	 * \return	1 if a model was found, 0 if the problem is unsatisfiable, -1 to restart, or -2 if
+	 *			the budget was exceeded
+	 */
+	int Sat::search(unsigned long conflicts, Budget& budget) {
+		vector<int> learnt;
+		unsigned long found = 0;
+
+		for(;;) {
+			Clause* conflict = propagate();
+
+			if(conflict) {
+				int backtrackLevel;
+
+				Conflicts++;
+				found++;
+				if(TrailLim.empty())
+					return 0;
+
+				if(!budget.spend()) {
+					cancelUntil(0);
+					return -2;
+				}
+
+				analyze(conflict, learnt, backtrackLevel);
+				cancelUntil(backtrackLevel);
+
+				if(learnt.size() == 1) {
+					enqueue(learnt[0], 0);
+				} else {
+					Clause* c = new Clause();
+					c->Lits = learnt;
+					c->Learnt = true;
+					c->Deleted = false;
+					c->Activity = 0;
+					Learnts.push_back(c);
+					attach(c);
+					bumpClause(c);
+					enqueue(learnt[0], c);
+				}
+
+				VarInc /= 0.95;
+				ClauseInc /= 0.999;
+			} else {
+				if(found >= conflicts) {
+					cancelUntil(0);
+					return -1;
+				}
+
+				if(Learnts.size() >= Clauses.size() / 3 + Trail.size() + 1000)
+					reduce();
+
+				int next = pickBranch();
+
+				if(next < 0)
+					return 1;
+
+				TrailLim.push_back(Trail.size());
+				enqueue(next, 0);
+			}
+		}
+	}
+
+	/**
+	 * Solves the problem given by the clauses added so far.
+	 * \return	true if it's satisfiable; the model can be read then with modelValue()
+	 */
+	bool Sat::solve() {
+		Budget unlimited;
+
+		return solve(unlimited);
+	}
+
+	/**
+	 * Solves the problem given by the clauses added so far, within a budget.
+	 * \arg		budget	limits of the search, spending a node per conflict
+	 * \return	true if it's satisfiable; the model can be read then with modelValue(). If not,
+	 *			budget.exceeded() tells whether it's unsatisfiable or the search was stopped, in
+	 *			which case solve() can be called again
+	 */
+	bool Sat::solve(Budget& budget) {
+		int status = -1;
+
+		if(!Ok)
+			return false;
+
+		SUDOKU_TRACE_SPAN("sat");
+
+		for(unsigned long restart = 0; status == -1; restart++) {
+			SUDOKU_TRACE_EVENT("sat restart", restart);
+			status = search(static_cast<unsigned long>(luby(2, restart) * 100), budget);
+		}
+
+		if(status == 1) {
+			Model = Assigns;
+			cancelUntil(0);
+			return true;
+		}
+
+		if(status == 0)
+			Ok = false;
+		return false;
+	}
+
+	/**
+	 * Returns the value of a variable in the model found by the last successful solve().
+	 */
+	bool Sat::modelValue(int var) const {
+		return Model[var] == 1;
+	}
+
+	/**
+	 * Returns the number of conflicts found so far.
+	 */
+	unsigned long Sat::getConflicts() const {
+		return Conflicts;
+	}
+
+	/**
+	 * Bumps the activity of a variable involved in a conflict.
+	 */
+	void Sat::bumpVariable(int var) {
+		if((Activity[var] += VarInc) > 1e100) {
+			for(size_t i = 0; i < Activity.size(); i++)
+				Activity[i] *= 1e-100;
+			VarInc *= 1e-100;
+		}
+
+		if(HeapIndex[var] >= 0)
+			heapUp(HeapIndex[var]);
+	}
+
+	/**
+	 * Bumps the activity of a learnt clause involved in a conflict.
+	 */
+	void Sat::bumpClause(Clause* clause) {
+		if((clause->Activity += ClauseInc) > 1e20) {
+			for(size_t i = 0; i < Learnts.size(); i++)
+				Learnts[i]->Activity *= 1e-20;
+			ClauseInc *= 1e-20;
+		}
+	}
+
+	/**
+	 * Heap order: the most active variables first.
+	 */
+	inline bool Sat::heapLess(int a, int b) const {
+		return Activity[a] > Activity[b];
+	}
+
+	void Sat::heapUp(int i) {
+		int var = Heap[i];
+
+		while(i > 0 && heapLess(var, Heap[(i - 1) / 2])) {
+			Heap[i] = Heap[(i - 1) / 2];
+			HeapIndex[Heap[i]] = i;
+			i = (i - 1) / 2;
+		}
+
+		Heap[i] = var;
+		HeapIndex[var] = i;
+	}
+
+	void Sat::heapDown(int i) {
+		int var = Heap[i], size = Heap.size();
+
+		while(2 * i + 1 < size) {
+			int child = 2 * i + 1;
+
+			if(child + 1 < size && heapLess(Heap[child + 1], Heap[child]))
+				child++;
+			if(!heapLess(Heap[child], var))
+				break;
+
+			Heap[i] = Heap[child];
+			HeapIndex[Heap[i]] = i;
+			i = child;
+		}
+
+		Heap[i] = var;
+		HeapIndex[var] = i;
+	}
+
+	void Sat::heapInsert(int var) {
+		Heap.push_back(var);
+		heapUp(Heap.size() - 1);
+	}
+
+	int Sat::heapPop() {
+		int var = Heap[0];
+
+		Heap[0] = Heap.back();
+		HeapIndex[Heap[0]] = 0;
+		Heap.pop_back();
+		HeapIndex[var] = -1;
+
+		if(!Heap.empty())
+			heapDown(0);
+
+		return var;
+	}
+
+	/**
+	 * Returns the variable stating that a cell holds a value.
+	 */
+	inline int SatSolver::variable(short unsigned int c, short unsigned int myP) {
+		return c * 9 + myP - 1;
+	}
+
+	/**
+	 * Encodes a board state as CNF.
+	 * \arg		grid	state to encode
+	 * \arg		sat		solver where the variables and clauses are added; it must be empty
+	 */
+	void SatSolver::encode(const Grid& grid, Sat& sat) {
+		vector<int> clause;
+
+		for(short unsigned int i = 0; i < 81 * 9; i++)
+			sat.newVariable();
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			short unsigned int candidates = grid.getCandidates(c);
+
+			// Each cell holds at least one of its candidates and at most one value
+			clause.clear();
+			for(short unsigned int p = 1; p < 10; p++)
+				if(candidates & (1 << (p - 1)))
+					clause.push_back(Sat::lit(variable(c, p), true));
+			sat.addClause(clause);
+
+			for(short unsigned int p = 1; p < 10; p++) {
+				if(!(candidates & (1 << (p - 1)))) {
+					clause.assign(1, Sat::lit(variable(c, p), false));
+					sat.addClause(clause);
+				}
+
+				for(short unsigned int q = p + 1; q < 10; q++) {
+					clause.clear();
+					clause.push_back(Sat::lit(variable(c, p), false));
+					clause.push_back(Sat::lit(variable(c, q), false));
+					sat.addClause(clause);
+				}
+			}
+		}
+
+		// Each value appears at least once and at most once in every unit
+		for(short unsigned int u = 0; u < 27; u++) {
+			for(short unsigned int p = 1; p < 10; p++) {
+				clause.clear();
+				for(short unsigned int i = 0; i < 9; i++)
+					clause.push_back(Sat::lit(variable(UnitCells[u][i], p), true));
+				sat.addClause(clause);
+
+				for(short unsigned int i = 0; i < 9; i++) {
+					for(short unsigned int j = i + 1; j < 9; j++) {
+						clause.clear();
+						clause.push_back(Sat::lit(variable(UnitCells[u][i], p), false));
+						clause.push_back(Sat::lit(variable(UnitCells[u][j], p), false));
+						sat.addClause(clause);
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * Solves a sudoku board with the SAT solver, leaving the solution in it if there's any.
+	 * \arg		Sudoku	board to solve
+	 * \return	true if the board has a solution
+	 */
+	bool SatSolver::solve(Board& Sudoku) {
+		Budget unlimited;
+
+		return solve(Sudoku, unlimited);
+	}
+
+	/**
+	 * Solves a sudoku board with the SAT solver within a budget, leaving the solution in it if one
+	 * was found.
+	 * \arg		Sudoku	board to solve
+	 * \arg		budget	limits of the search, spending a node per conflict
+	 * \return	true if a solution was found; if not, budget.exceeded() tells whether the board has
+	 *			no solution or the search was stopped
+	 */
+	bool SatSolver::solve(Board& Sudoku, Budget& budget) {
+		Grid grid;
+		Sat sat;
+
+		if(!grid.load(Sudoku))
+			return false;
+
+		encode(grid, sat);
+
+		if(!sat.solve(budget))
+			return false;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			for(short unsigned int p = 1; p < 10; p++)
+				if(sat.modelValue(variable(c, p)) && !grid.assign(c, p))
+					return false;
+
+		grid.store(Sudoku);
+		return true;
+	}
+
+	/**
+	 * Enumerates the solutions of a grid with the SAT solver, handing each of them to a visitor.
+	 * Every solution found is forbidden with a clause before looking for the next one, so the
+	 * clauses learnt so far are kept from one solution to the next.
+	 * \arg		grid	state whose solutions are enumerated
+	 * \arg		visitor	function receiving each solution; it returns false to stop
+	 * \arg		context	argument given to the visitor
+	 * \arg		budget	limits of the search, spending a node per conflict
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to visit them all
+	 * \return	number of solutions visited
+	 */
+	unsigned long SatSolver::enumerate(const Grid& grid, tVisitor visitor, void* context, Budget& budget,
+		unsigned long limit)
+	{
+		SUDOKU_TRACE_SPAN("sat enumerate");
+		Sat sat;
+		vector<int> blocking;
+		unsigned long found = 0;
+
+		encode(grid, sat);
+
+		while((limit == 0 || found < limit) && sat.solve(budget)) {
+			Grid solution = grid;
+
+			blocking.clear();
+			for(short unsigned int c = 0; c < 81; c++)
+				for(short unsigned int p = 1; p < 10; p++)
+					if(sat.modelValue(variable(c, p))) {
+						if(!solution.assign(c, p))
+							return found;
+						if(grid.get(c) == 0)
+							blocking.push_back(Sat::lit(variable(c, p), false));
+					}
+
+			found++;
+			if(!visitor(solution, context) || blocking.empty() || !sat.addClause(blocking))
+				break;
+		}
+
+		return found;
+	}
+}
+}
@@ -0,0 +1,97 @@
+// See COPYING file for licensing information.
+/**
+ * \file sat.h
+ * Definition of a CDCL satisfiability solver and of the engine solving sudoku boards with it.
+ */
+
+#ifndef SAT_H
+#define SAT_H
+
+#include "sudoku.h"
+#include "search.h"
+#include "budget.h"
+#include <vector>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Conflict-driven clause learning SAT solver.
+	 * Variables are numbered from 0 and a literal is 2 * variable for the variable being true, or
+	 * 2 * variable + 1 for it being false. It keeps two watched literals per clause, learns a first
+	 * UIP clause from each conflict, branches with VSIDS and saved phases, and restarts following
+	 * the Luby sequence.
+	 */
+	class Sat {
+		struct Clause {
+			vector<int> Lits;
+			bool Learnt;
+			bool Deleted;
+			double Activity;
+		};
+
+		vector<Clause*> Clauses, Learnts;
+		vector< vector<Clause*> > Watches;
+		vector<signed char> Assigns, Polarity, Model;
+		vector<int> Level, Trail, TrailLim, Heap, HeapIndex;
+		vector<Clause*> Reason;
+		vector<double> Activity;
+		vector<char> Seen;
+		double VarInc, ClauseInc;
+		unsigned int QHead;
+		bool Ok;
+		unsigned long Conflicts;
+
+		Sat(const Sat& copy);
+
+		signed char value(int lit) const;
+		void enqueue(int lit, Clause* reason);
+		Clause* propagate();
+		void analyze(Clause* conflict, vector<int>& learnt, int& backtrackLevel);
+		void cancelUntil(int level);
+		void attach(Clause* clause);
+		void reduce();
+		bool locked(const Clause* clause) const;
+		int pickBranch();
+		int search(unsigned long conflicts, Budget& budget);
+		void bumpVariable(int var);
+		void bumpClause(Clause* clause);
+
+		bool heapLess(int a, int b) const;
+		void heapUp(int i);
+		void heapDown(int i);
+		void heapInsert(int var);
+		int heapPop();
+	public:
+		Sat();
+		~Sat();
+
+		static int lit(int var, bool positive);
+
+		int newVariable();
+		int variables() const;
+		bool addClause(const vector<int>& lits);
+		bool solve();
+		bool solve(Budget& budget);
+		bool modelValue(int var) const;
+		unsigned long getConflicts() const;
+	};
+
+	/**
+	 * Engine solving a sudoku board by encoding it as CNF: each cell holds exactly one value, each
+	 * value appears exactly once in every unit, and the decided cells and removed candidates of the
+	 * board become unit clauses.
+	 */
+	class SatSolver {
+		SatSolver();
+
+		static int variable(short unsigned int c, short unsigned int myP);
+	public:
+		static void encode(const Grid& grid, Sat& sat);
+		static bool solve(Board& Sudoku);
+		static bool solve(Board& Sudoku, Budget& budget);
+		static unsigned long enumerate(const Grid& grid, tVisitor visitor, void* context, Budget& budget,
+			unsigned long limit = 0);
+	};
+}
+}
+#endif
@@ -0,0 +1,1079 @@
+// See COPYING file for licensing information.
+/**
+ * \file search.cpp
+ * Implementation of the backtracking search used to solve any sudoku board.
+ */
+#include "search.h"
+#include "tables.h"
+#include "trace.h"
+#include <sched.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Returns the number of candidates set in a bitmask.
+	 */
+	static inline short unsigned int countBits(short unsigned int mask) {
+		return __builtin_popcount(mask);
+	}
+
+	/**
+	 * Returns the lowest value set in a non empty bitmask.
+	 */
+	static inline short unsigned int lowestValue(short unsigned int mask) {
+		return __builtin_ctz(mask) + 1;
+	}
+
+	/**
+	 * Zobrist keys of the values set in each cell, and of the candidates removed from outside.
+	 */
+	static unsigned long long Keys[2][81][9];
+
+	/**
+	 * Fills the Zobrist keys at startup, always with the same numbers (splitmix64).
+	 */
+	static struct KeysInitializer {
+		KeysInitializer() {
+			unsigned long long state = 0x5D0C0DE5ULL;
+
+			for(short unsigned int k = 0; k < 2; k++)
+				for(short unsigned int c = 0; c < 81; c++)
+					for(short unsigned int v = 0; v < 9; v++) {
+						unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+
+						z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+						z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+						Keys[k][c][v] = z ^ (z >> 31);
+					}
+		}
+	} keysInitializer;
+
+	/**
+	 * Grid constructor.
+	 * Every cell is undecided and all the values in [1,9] are possible.
+	 */
+	Grid::Grid()
+		: Unsolved(81), Key(0)
+	{
+		for(short unsigned int i = 0; i < 81; i++) {
+			Candidates[i] = 0x1FF;
+			Values[i] = 0;
+		}
+
+		memset(Buckets, 0, sizeof(Buckets));
+		memset(Pairs, 0, sizeof(Pairs));
+		memset(Places, 9, sizeof(Places));
+		Buckets[9][0] = ~0ULL;
+		Buckets[9][1] = (1ULL << 17) - 1;
+	}
+
+	/**
+	 * Moves an undecided cell from the bucket of a number of candidates to another one.
+	 * \arg		cell	index of the cell
+	 * \arg		from	number of candidates it had, or 0 if it wasn't in any bucket
+	 * \arg		to		number of candidates it has, or 0 to take it out of the buckets
+	 */
+	inline void Grid::refile(short unsigned int cell, short unsigned int from, short unsigned int to) {
+		unsigned long long bit = 1ULL << (cell & 63);
+
+		Buckets[from][cell >> 6] &= ~bit;
+		Buckets[to][cell >> 6] |= bit;
+		Buckets[0][cell >> 6] = 0;
+	}
+
+	/**
+	 * Loads the state of a Board, propagating its definitive cells.
+	 * Undecided cells keep only the possibilities still listed in the Board.
+	 * \arg		Sudoku	Board to load
+	 * \return	false if the board contains a contradiction, true otherwise
+	 */
+	bool Grid::load(Board& Sudoku) {
+		SUDOKU_TRACE_SPAN("load");
+
+		*this = Grid();
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			Cell& cell = *Sudoku.Cells[c];
+
+			if(cell.State == undecided) {
+				short unsigned int possible = 0;
+
+				for(short unsigned int i = 0; i < 9 && cell.Possibilities[i] != 0; i++)
+					possible |= 1 << (cell.Possibilities[i] - 1);
+
+				for(short unsigned int p = 1; p < 10; p++)
+					if(!(possible & (1 << (p - 1))) && !eliminate(c, p))
+						return false;
+			}
+		}
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(Sudoku.Cells[c]->State == definitive && !assign(c, Sudoku.Cells[c]->Possibilities[0]))
+				return false;
+
+		return true;
+	}
+
+	/**
+	 * Stores this state into a Board.
+	 * Decided cells are set to definitive and undecided ones get their candidates as possibilities.
+	 * \arg		Sudoku	Board where the state is stored
+	 */
+	void Grid::store(Board& Sudoku) const {
+		for(short unsigned int c = 0; c < 81; c++) {
+			Cell& cell = *Sudoku.Cells[c];
+
+			if(Values[c] != 0) {
+				cell.State = definitive;
+				cell.Possibilities[0] = Values[c];
+				cell.Possibilities[1] = 0;
+			} else {
+				short unsigned int i = 0;
+
+				for(short unsigned int p = 1; p < 10; p++)
+					if(Candidates[c] & (1 << (p - 1)))
+						cell.Possibilities[i++] = p;
+				for(; i < 9; i++)
+					cell.Possibilities[i] = 0;
+
+				cell.State = undecided;
+			}
+		}
+	}
+
+	/**
+	 * Sets the definitive value of a cell and propagates it.
+	 * The value is removed from every other cell of its row, column and box, and any cell left with
+	 * a single candidate, or any value left with a single place in a unit, is set in turn.
+	 * \arg		cell	index of the cell within the board, in the range [0,80]
+	 * \arg		myP		the value to set, in the range [1,9]
+	 * \return	false if the propagation led to a contradiction, true otherwise
+	 */
+	bool Grid::assign(short unsigned int cell, short unsigned int myP) {
+		short unsigned int bit = 1 << (myP - 1);
+
+		if(!(Candidates[cell] & bit))
+			return false;
+		else if(Values[cell] == myP)
+			return true;
+
+		refile(cell, countBits(Candidates[cell]), 0);
+		Values[cell] = myP;
+		Unsolved--;
+		Key ^= Keys[0][cell][myP - 1];
+
+		short unsigned int others = Candidates[cell] & ~bit;
+
+		while(others) {
+			if(!exclude(cell, lowestValue(others)))
+				return false;
+			others &= others - 1;
+		}
+
+		for(short unsigned int i = 0; i < 20; i++)
+			if(!exclude(Peers[cell][i], myP))
+				return false;
+
+		return true;
+	}
+
+	/**
+	 * Removes a candidate from a cell and propagates the consequences.
+	 * \arg		cell	index of the cell within the board, in the range [0,80]
+	 * \arg		myP		the value to remove, in the range [1,9]
+	 * \return	false if the cell or one of its units is left with no place for a value, true otherwise
+	 */
+	bool Grid::eliminate(short unsigned int cell, short unsigned int myP) {
+		if(Candidates[cell] & (1 << (myP - 1)))
+			Key ^= Keys[1][cell][myP - 1];
+
+		return exclude(cell, myP);
+	}
+
+	/**
+	 * Removes a candidate from a cell as a consequence of another one, which doesn't change the
+	 * key, and propagates it.
+	 * \arg		cell	index of the cell within the board, in the range [0,80]
+	 * \arg		myP		the value to remove, in the range [1,9]
+	 * \return	false if the cell or one of its units is left with no place for a value, true otherwise
+	 */
+	bool Grid::exclude(short unsigned int cell, short unsigned int myP) {
+		short unsigned int bit = 1 << (myP - 1), left;
+
+		if(!(Candidates[cell] & bit))
+			return true;
+
+		Candidates[cell] &= ~bit;
+		left = countBits(Candidates[cell]);
+		if(Values[cell] == 0)
+			refile(cell, left + 1, left);
+
+		// One place less for the value in each unit of the cell
+		for(short unsigned int kind = 0; kind < 3; kind++) {
+			short unsigned int pair = CellUnits[cell][kind] * 9 + myP - 1;
+			unsigned char places = --Places[CellUnits[cell][kind]][myP - 1];
+
+			if(places == 2)
+				Pairs[pair >> 6] |= 1ULL << (pair & 63);
+			else if(places == 1)
+				Pairs[pair >> 6] &= ~(1ULL << (pair & 63));
+		}
+
+		if(left == 0)
+			return false;
+		else if(Values[cell] == 0 && left == 1 && !assign(cell, lowestValue(Candidates[cell])))
+			return false;
+
+		// The removed value must still fit somewhere in each unit of the cell
+		for(short unsigned int kind = 0; kind < 3; kind++) {
+			short unsigned int unit = CellUnits[cell][kind];
+
+			if(Places[unit][myP - 1] == 0)
+				return false;
+			else if(Places[unit][myP - 1] == 1) {
+				short unsigned int place = 0;
+
+				while(!(Candidates[UnitCells[unit][place]] & bit))
+					place++;
+				place = UnitCells[unit][place];
+
+				if(Values[place] == 0 && !assign(place, myP))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Chooses the undecided cell with the fewest candidates, to branch on it: the first cell of the
+	 * first bucket which isn't empty.
+	 * \return	index of the chosen cell, or 81 if every cell is decided
+	 */
+	short unsigned int Grid::choose() const {
+		for(short unsigned int n = 1; n < 10; n++) {
+			if(Buckets[n][0])
+				return __builtin_ctzll(Buckets[n][0]);
+			if(Buckets[n][1])
+				return 64 + __builtin_ctzll(Buckets[n][1]);
+		}
+
+		return 81;
+	}
+
+	/**
+	 * Chooses the next branch of the search. It's the candidates of the cell with the fewest of
+	 * them, unless that's more than two and a value has only two places left in a unit: the
+	 * branch is then these two places.
+	 * \arg		branch	set to the alternatives, none if every cell is decided
+	 */
+	void Grid::branch(Branch& branch) const {
+		short unsigned int cell = choose();
+
+		branch.Count = 0;
+		if(cell == 81)
+			return;
+
+		if(countBits(Candidates[cell]) > 2) {
+			for(short unsigned int w = 0; w < 4; w++) {
+				if(Pairs[w] == 0)
+					continue;
+
+				short unsigned int pair = w * 64 + __builtin_ctzll(Pairs[w]), unit = pair / 9, myP = pair % 9 + 1;
+
+				for(short unsigned int i = 0; i < 9; i++)
+					if(Candidates[UnitCells[unit][i]] & (1 << (myP - 1))) {
+						branch.Cells[branch.Count] = UnitCells[unit][i];
+						branch.Values[branch.Count++] = myP;
+					}
+				return;
+			}
+		}
+
+		for(short unsigned int mask = Candidates[cell]; mask; mask &= mask - 1) {
+			branch.Cells[branch.Count] = cell;
+			branch.Values[branch.Count++] = lowestValue(mask);
+		}
+	}
+
+	/**
+	 * Returns the definitive value of a cell, or 0 if it's still undecided.
+	 */
+	short unsigned int Grid::get(short unsigned int cell) const {
+		return Values[cell];
+	}
+
+	/**
+	 * Returns the candidates bitmask of a cell.
+	 */
+	short unsigned int Grid::getCandidates(short unsigned int cell) const {
+		return Candidates[cell];
+	}
+
+	/**
+	 * Returns true if all cells are decided.
+	 */
+	bool Grid::isSolved() const {
+		return Unsolved == 0;
+	}
+
+	/**
+	 * Returns the Zobrist key of the state. Two grids reached from the same values and removed
+	 * candidates, in any order, have the same key.
+	 */
+	unsigned long long Grid::getKey() const {
+		return Key;
+	}
+
+	/**
+	 * TranspositionTable constructor.
+	 * \arg		bytes	memory to use; the number of buckets is the largest power of two fitting in it
+	 */
+	TranspositionTable::TranspositionTable(size_t bytes)
+		: Mask(1), Probes(0), Hits(0)
+	{
+		while(Mask * 4 * sizeof(Transposition) <= bytes)
+			Mask <<= 1;
+
+		Entries = new Transposition[Mask * 2];
+		Mask--;
+		clear();
+	}
+
+	/**
+	 * TranspositionTable destructor.
+	 */
+	TranspositionTable::~TranspositionTable() {
+		delete[] Entries;
+	}
+
+	/**
+	 * Looks for the result of a subtree.
+	 * \arg		key		key of the root of the subtree
+	 * \arg		count	set to its number of solutions
+	 * \arg		exact	set to false if count is only a lower bound
+	 * \return	false if the subtree isn't in the table
+	 */
+	bool TranspositionTable::probe(unsigned long long key, unsigned long& count, bool& exact) {
+		Transposition* bucket = &Entries[(key & Mask) * 2];
+
+		Probes++;
+		for(short unsigned int i = 0; i < 2; i++)
+			if(bucket[i].Key == key && (bucket[i].Exact || bucket[i].Count != 0)) {
+				count = bucket[i].Count;
+				exact = bucket[i].Exact;
+				Hits++;
+				return true;
+			}
+
+		return false;
+	}
+
+	/**
+	 * Keeps the result of a subtree. If the subtree is already there the best result is kept;
+	 * otherwise it goes to the first entry of its bucket if it's at least as big as the one there,
+	 * which moves to the second entry, or else to the second entry.
+	 * \arg		key			key of the root of the subtree
+	 * \arg		count		its number of solutions
+	 * \arg		exact		false if count is only a lower bound
+	 * \arg		unsolved	undecided cells of the root, telling how big the subtree is
+	 */
+	void TranspositionTable::store(unsigned long long key, unsigned long count, bool exact,
+		short unsigned int unsolved)
+	{
+		Transposition* bucket = &Entries[(key & Mask) * 2];
+		Transposition* entry = &bucket[1];
+
+		if(bucket[0].Key == key)
+			entry = &bucket[0];
+		else if(bucket[1].Key != key && unsolved >= bucket[0].Unsolved) {
+			// The entry it replaces is still the latest one
+			bucket[1] = bucket[0];
+			entry = &bucket[0];
+		}
+
+		if(entry->Key == key && (entry->Exact || (!exact && entry->Count >= count)))
+			return;
+
+		entry->Key = key;
+		entry->Count = count;
+		entry->Exact = exact;
+		entry->Unsolved = unsolved;
+	}
+
+	/**
+	 * Empties the table.
+	 */
+	void TranspositionTable::clear() {
+		memset(Entries, 0, (Mask + 1) * 2 * sizeof(Transposition));
+		Probes = Hits = 0;
+	}
+
+	/**
+	 * Returns the number of lookups done since the table was built or cleared.
+	 */
+	unsigned long TranspositionTable::getProbes() const {
+		return Probes;
+	}
+
+	/**
+	 * Returns the number of lookups which found their subtree.
+	 */
+	unsigned long TranspositionTable::getHits() const {
+		return Hits;
+	}
+
+	/**
+	 * WorkQueue constructor.
+	 */
+	WorkQueue::WorkQueue() {
+		pthread_mutex_init(&Lock, 0);
+	}
+
+	/**
+	 * WorkQueue destructor.
+	 */
+	WorkQueue::~WorkQueue() {
+		pthread_mutex_destroy(&Lock);
+	}
+
+	/**
+	 * Queues a subtree at the bottom of the queue.
+	 */
+	void WorkQueue::push(const Grid& grid) {
+		pthread_mutex_lock(&Lock);
+		Tasks.push_back(grid);
+		pthread_mutex_unlock(&Lock);
+	}
+
+	/**
+	 * Takes the newest subtree from the bottom of the queue. Used by the owner thread.
+	 * \return	false if the queue was empty
+	 */
+	bool WorkQueue::pop(Grid& grid) {
+		bool found = false;
+
+		pthread_mutex_lock(&Lock);
+		if(!Tasks.empty()) {
+			grid = Tasks.back();
+			Tasks.pop_back();
+			found = true;
+		}
+		pthread_mutex_unlock(&Lock);
+
+		return found;
+	}
+
+	/**
+	 * Takes the oldest subtree from the top of the queue. Used by idle threads.
+	 * \return	false if the queue was empty
+	 */
+	bool WorkQueue::steal(Grid& grid) {
+		bool found = false;
+
+		pthread_mutex_lock(&Lock);
+		if(!Tasks.empty()) {
+			grid = Tasks.front();
+			Tasks.pop_front();
+			found = true;
+		}
+		pthread_mutex_unlock(&Lock);
+
+		return found;
+	}
+
+	/**
+	 * Solutions counted by one thread, alone in its cache line so that the threads don't slow
+	 * each other down while counting.
+	 */
+	typedef struct {
+		unsigned long Found;
+		char Padding[64 - sizeof(unsigned long)];
+	} Tally;
+
+	/**
+	 * State shared by all the threads taking part in a parallel search.
+	 */
+	class SearchJob {
+	public:
+		WorkQueue* Queues;
+		short unsigned int Workers;
+		volatile short unsigned int Started;
+		volatile long Pending;	// subtrees queued or being explored
+		volatile long Idle;		// threads looking for a subtree to steal
+		volatile int Stop;		// set to cancel every thread once the search is over
+
+		bool Counting;
+		unsigned long Limit;
+		volatile unsigned long Found;	// solutions counted with a limit or visited
+		Tally* Tallies;					// solutions counted by each thread without a limit
+		Budget& Limits;
+		tVisitor Visitor;
+		void* Context;
+
+		pthread_mutex_t Lock;
+		bool Solved;
+		Grid Solution;
+
+		SearchJob(short unsigned int workers, bool counting, unsigned long limit, Budget& budget,
+			tVisitor visitor = 0, void* context = 0)
+			: Workers(workers), Started(0), Pending(0), Idle(0), Stop(0),
+			  Counting(counting), Limit(limit), Found(0), Limits(budget), Visitor(visitor), Context(context),
+			  Solved(false)
+		{
+			Queues = new WorkQueue[workers];
+			Tallies = new Tally[workers];
+			for(short unsigned int i = 0; i < workers; i++)
+				Tallies[i].Found = 0;
+			pthread_mutex_init(&Lock, 0);
+		}
+
+		~SearchJob() {
+			pthread_mutex_destroy(&Lock);
+			delete[] Tallies;
+			delete[] Queues;
+		}
+
+		/**
+		 * Returns the solutions found by all the threads, once they are done.
+		 */
+		unsigned long total() const {
+			unsigned long found = Found;
+
+			for(short unsigned int i = 0; i < Workers; i++)
+				found += Tallies[i].Found;
+
+			return (Limit != 0 && found > Limit) ? Limit : found;
+		}
+	};
+
+	/**
+	 * Returns the number of processors available to run search threads.
+	 */
+	short unsigned int Search::cores() {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+		return n > 0 ? static_cast<short unsigned int>(n) : 1;
+	}
+
+	/**
+	 * Depth-first search of the first solution, without any thread.
+	 * \arg		grid	state to solve; on success it's replaced by the solution
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		table	subtrees known to have no solution, or 0
+	 * \return	true if a solution was found
+	 */
+	bool Search::first(Grid& grid, Budget& budget, TranspositionTable* table) {
+		if(grid.Unsolved == 0)
+			return true;
+
+		unsigned long known;
+		bool exact;
+
+		if(table != 0 && table->probe(grid.Key, known, exact) && exact && known == 0)
+			return false;
+
+		if(!budget.spend())
+			return false;
+
+		Branch branch;
+
+		grid.branch(branch);
+		SUDOKU_TRACE_EVENT("branch", branch.Cells[0]);
+		for(short unsigned int i = 0; i < branch.Count; i++) {
+			Grid child = grid;
+
+			if(child.assign(branch.Cells[i], branch.Values[i]) && first(child, budget, table)) {
+				grid = child;
+				return true;
+			}
+		}
+
+		if(table != 0 && !budget.exceeded())
+			table->store(grid.Key, 0, true, grid.Unsolved);
+
+		return false;
+	}
+
+	/**
+	 * Depth-first count of the solutions, without any thread.
+	 * \arg		grid	state whose solutions are counted
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \arg		found	counter of solutions found so far
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		table	solutions of the subtrees already explored, or 0
+	 */
+	void Search::tally(const Grid& grid, unsigned long limit, unsigned long& found, Budget& budget,
+		TranspositionTable* table)
+	{
+		if(grid.Unsolved == 0) {
+			found++;
+			return;
+		}
+
+		unsigned long known;
+		bool exact;
+
+		// A lower bound is enough if it reaches the limit
+		if(table != 0 && table->probe(grid.Key, known, exact) && (exact || (limit != 0 && found + known >= limit))) {
+			found += known;
+			return;
+		}
+
+		if(!budget.spend())
+			return;
+
+		Branch branch;
+		unsigned long before = found;
+
+		grid.branch(branch);
+		SUDOKU_TRACE_EVENT("branch", branch.Cells[0]);
+		for(short unsigned int i = 0; i < branch.Count && (limit == 0 || found < limit); i++) {
+			Grid child = grid;
+
+			if(child.assign(branch.Cells[i], branch.Values[i]))
+				tally(child, limit, found, budget, table);
+		}
+
+		if(table != 0) {
+			// The subtree may have been cut by the limit or the budget
+			exact = (limit == 0 || found < limit) && !budget.exceeded();
+			if(exact || found > before)
+				table->store(grid.Key, found - before, exact, grid.Unsolved);
+		}
+	}
+
+	/**
+	 * Depth-first enumeration of the solutions, without any thread.
+	 * \arg		grid	state whose solutions are enumerated
+	 * \arg		visitor	function receiving each solution
+	 * \arg		context	argument given to the visitor
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to visit them all
+	 * \arg		found	counter of solutions visited so far
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \return	false once the enumeration must stop
+	 */
+	bool Search::walk(const Grid& grid, tVisitor visitor, void* context, unsigned long limit,
+		unsigned long& found, Budget& budget)
+	{
+		if(grid.Unsolved == 0) {
+			found++;
+			return visitor(grid, context) && (limit == 0 || found < limit);
+		}
+
+		if(!budget.spend())
+			return false;
+
+		Branch branch;
+
+		grid.branch(branch);
+		SUDOKU_TRACE_EVENT("branch", branch.Cells[0]);
+		for(short unsigned int i = 0; i < branch.Count; i++) {
+			Grid child = grid;
+
+			if(child.assign(branch.Cells[i], branch.Values[i]) && !walk(child, visitor, context, limit, found, budget))
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Depth-first exploration of a subtree by one of the threads of a parallel search.
+	 * While some thread is idle, the pending siblings of the branch being explored are queued
+	 * so that they can be stolen instead of being explored afterwards by this thread.
+	 * \arg		grid	root of the subtree
+	 * \arg		job		shared search state
+	 * \arg		own		queue of the thread exploring the subtree
+	 */
+	void Search::explore(Grid& grid, SearchJob& job, WorkQueue& own) {
+		if(job.Stop)
+			return;
+
+		if(grid.Unsolved != 0 && !job.Limits.share()) {
+			job.Stop = 1;
+			return;
+		}
+
+		if(grid.Unsolved == 0) {
+			if(job.Visitor != 0) {
+				// Solutions are handed to the visitor one at a time
+				pthread_mutex_lock(&job.Lock);
+				if(!job.Stop) {
+					job.Found++;
+					if(!job.Visitor(grid, job.Context) || (job.Limit != 0 && job.Found >= job.Limit))
+						job.Stop = 1;
+				}
+				pthread_mutex_unlock(&job.Lock);
+			} else if(job.Counting && job.Limit == 0) {
+				job.Tallies[&own - job.Queues].Found++;
+			} else if(job.Counting) {
+				unsigned long found = __sync_add_and_fetch(&job.Found, 1);
+
+				if(found >= job.Limit)
+					job.Stop = 1;
+			} else {
+				pthread_mutex_lock(&job.Lock);
+				if(!job.Solved) {
+					job.Solution = grid;
+					job.Solved = true;
+				}
+				job.Stop = 1;
+				pthread_mutex_unlock(&job.Lock);
+			}
+			return;
+		}
+
+		Branch branch;
+
+		grid.branch(branch);
+		SUDOKU_TRACE_EVENT("branch", branch.Cells[0]);
+		for(short unsigned int i = 0; i < branch.Count && !job.Stop; i++) {
+			// Share the remaining siblings with the idle threads
+			if(i + 1 < branch.Count && job.Idle > 0) {
+				for(short unsigned int j = i + 1; j < branch.Count; j++) {
+					Grid sibling = grid;
+
+					if(sibling.assign(branch.Cells[j], branch.Values[j])) {
+						__sync_add_and_fetch(&job.Pending, 1);
+						own.push(sibling);
+					}
+				}
+				branch.Count = i + 1;
+			}
+
+			Grid child = grid;
+
+			if(child.assign(branch.Cells[i], branch.Values[i]))
+				explore(child, job, own);
+		}
+	}
+
+	/**
+	 * Main loop of every search thread: explores its own subtrees and, when it runs out of them,
+	 * steals from the other threads till there is no subtree left or the search is cancelled.
+	 * \arg		job		pointer to the shared SearchJob
+	 */
+	void* Search::worker(void* job) {
+		SearchJob& Job = *static_cast<SearchJob*>(job);
+		short unsigned int id = __sync_fetch_and_add(&Job.Started, 1);
+		WorkQueue& own = Job.Queues[id];
+		bool idle = false;
+		Grid grid;
+
+		while(!Job.Stop) {
+			bool found = own.pop(grid);
+
+			for(short unsigned int i = 1; !found && i < Job.Workers; i++)
+				found = Job.Queues[(id + i) % Job.Workers].steal(grid);
+
+			if(found) {
+				if(idle) {
+					__sync_sub_and_fetch(&Job.Idle, 1);
+					idle = false;
+				}
+
+				explore(grid, Job, own);
+				__sync_sub_and_fetch(&Job.Pending, 1);
+			} else if(Job.Pending == 0) {
+				break;
+			} else {
+				if(!idle) {
+					__sync_add_and_fetch(&Job.Idle, 1);
+					idle = true;
+				}
+				sched_yield();
+			}
+		}
+
+		if(idle)
+			__sync_sub_and_fetch(&Job.Idle, 1);
+
+		return 0;
+	}
+
+	/**
+	 * Runs a parallel search from a given root, with one thread per queue of the job.
+	 * The calling thread takes part in the search as the first worker.
+	 */
+	void Search::run(SearchJob& job, const Grid& grid) {
+		pthread_t* threads = new pthread_t[job.Workers];
+		short unsigned int started = 1;
+
+		job.Pending = 1;
+		job.Queues[0].push(grid);
+
+		for(; started < job.Workers; started++)
+			if(pthread_create(&threads[started], 0, worker, &job) != 0)
+				break;
+
+		// If some thread couldn't be created its queue is never used, and the others just skip it
+		worker(&job);
+
+		for(short unsigned int i = 1; i < started; i++)
+			pthread_join(threads[i], 0);
+
+		delete[] threads;
+	}
+
+	/**
+	 * Solves a grid, stopping at the first solution found.
+	 * \arg		grid	state to solve; on success it's replaced by the solution
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	true if the grid has a solution
+	 */
+	bool Search::solve(Grid& grid, short unsigned int threads) {
+		Budget unlimited;
+
+		return solve(grid, unlimited, threads);
+	}
+
+	/**
+	 * Solves a grid within a budget, stopping at the first solution found.
+	 * \arg		grid	state to solve; on success it's replaced by the solution
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	true if a solution was found; if not, budget.exceeded() tells whether the grid has
+	 *			no solution or the search was stopped
+	 */
+	bool Search::solve(Grid& grid, Budget& budget, short unsigned int threads) {
+		SUDOKU_TRACE_SPAN("search");
+
+		if(threads == 0)
+			threads = cores();
+
+		if(threads == 1)
+			return first(grid, budget);
+
+		SearchJob job(threads, false, 0, budget);
+		run(job, grid);
+
+		if(job.Solved)
+			grid = job.Solution;
+
+		return job.Solved;
+	}
+
+	/**
+	 * Solves a grid without threads, skipping the subtrees a table knows to have no solution and
+	 * adding to it the ones found.
+	 * \arg		grid	state to solve; on success it's replaced by the solution
+	 * \arg		table	subtrees already explored
+	 * \return	true if the grid has a solution
+	 */
+	bool Search::solve(Grid& grid, TranspositionTable& table) {
+		Budget unlimited;
+
+		return solve(grid, table, unlimited);
+	}
+
+	/**
+	 * Solves a grid within a budget and without threads, skipping the subtrees a table knows to
+	 * have no solution and adding to it the ones found.
+	 * \arg		grid	state to solve; on success it's replaced by the solution
+	 * \arg		table	subtrees already explored
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \return	true if a solution was found; if not, budget.exceeded() tells whether the grid has
+	 *			no solution or the search was stopped
+	 */
+	bool Search::solve(Grid& grid, TranspositionTable& table, Budget& budget) {
+		SUDOKU_TRACE_SPAN("search");
+
+		return first(grid, budget, &table);
+	}
+
+	/**
+	 * Solves a sudoku board, which is left with the solution if there's any.
+	 * \arg		Sudoku	board to solve
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	true if the board has a solution
+	 */
+	bool Search::solve(Board& Sudoku, short unsigned int threads) {
+		Grid grid;
+
+		if(!grid.load(Sudoku) || !solve(grid, threads))
+			return false;
+
+		grid.store(Sudoku);
+		return true;
+	}
+
+	/**
+	 * Solves a sudoku board within a budget, which is left with the solution if one was found.
+	 * \arg		Sudoku	board to solve
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	true if a solution was found; if not, budget.exceeded() tells whether the board has
+	 *			no solution or the search was stopped
+	 */
+	bool Search::solve(Board& Sudoku, Budget& budget, short unsigned int threads) {
+		Grid grid;
+
+		if(!grid.load(Sudoku) || !solve(grid, budget, threads))
+			return false;
+
+		grid.store(Sudoku);
+		return true;
+	}
+
+	/**
+	 * Counts the solutions of a grid.
+	 * \arg		grid	state whose solutions are counted
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	number of solutions found, which is at most limit if a limit was given
+	 */
+	unsigned long Search::count(const Grid& grid, unsigned long limit, short unsigned int threads) {
+		Budget unlimited;
+
+		return count(grid, unlimited, limit, threads);
+	}
+
+	/**
+	 * Counts the solutions of a grid within a budget.
+	 * \arg		grid	state whose solutions are counted
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	number of solutions found, which is at most limit if a limit was given; if
+	 *			budget.exceeded() it's only a lower bound
+	 */
+	unsigned long Search::count(const Grid& grid, Budget& budget, unsigned long limit, short unsigned int threads) {
+		SUDOKU_TRACE_SPAN("count");
+
+		if(threads == 0)
+			threads = cores();
+
+		if(threads == 1) {
+			unsigned long found = 0;
+
+			tally(grid, limit, found, budget);
+			return found;
+		}
+
+		SearchJob job(threads, true, limit, budget);
+		run(job, grid);
+
+		return job.total();
+	}
+
+	/**
+	 * Counts the solutions of a grid without threads, caching the subtrees explored in a table.
+	 * The table may be kept from one call to the next, so that later counts of grids sharing
+	 * states with earlier ones reuse their results.
+	 * \arg		grid	state whose solutions are counted
+	 * \arg		table	solutions of the subtrees already explored
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \return	number of solutions found, which is at most limit if a limit was given
+	 */
+	unsigned long Search::count(const Grid& grid, TranspositionTable& table, unsigned long limit) {
+		Budget unlimited;
+
+		return count(grid, table, unlimited, limit);
+	}
+
+	/**
+	 * Counts the solutions of a grid within a budget, without threads, caching the subtrees
+	 * explored in a table.
+	 * \arg		grid	state whose solutions are counted
+	 * \arg		table	solutions of the subtrees already explored
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \return	number of solutions found, which is at most limit if a limit was given; if
+	 *			budget.exceeded() it's only a lower bound
+	 */
+	unsigned long Search::count(const Grid& grid, TranspositionTable& table, Budget& budget, unsigned long limit) {
+		SUDOKU_TRACE_SPAN("count");
+		unsigned long found = 0;
+
+		tally(grid, limit, found, budget, &table);
+		return (limit != 0 && found > limit) ? limit : found;
+	}
+
+	/**
+	 * Counts the solutions of a sudoku board, which is not modified.
+	 * \arg		Sudoku	board whose solutions are counted
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	number of solutions found, which is at most limit if a limit was given
+	 */
+	unsigned long Search::count(Board& Sudoku, unsigned long limit, short unsigned int threads) {
+		Grid grid;
+
+		if(!grid.load(Sudoku))
+			return 0;
+
+		return count(grid, limit, threads);
+	}
+
+	/**
+	 * Counts the solutions of a sudoku board within a budget; the board is not modified.
+	 * \arg		Sudoku	board whose solutions are counted
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	number of solutions found, which is at most limit if a limit was given; if
+	 *			budget.exceeded() it's only a lower bound
+	 */
+	unsigned long Search::count(Board& Sudoku, Budget& budget, unsigned long limit, short unsigned int threads) {
+		Grid grid;
+
+		if(!grid.load(Sudoku))
+			return 0;
+
+		return count(grid, budget, limit, threads);
+	}
+
+	/**
+	 * Enumerates the solutions of a grid, handing each of them to a visitor as soon as it's found
+	 * instead of keeping them. When several threads are used, the visitor is called by any of
+	 * them, but never by two at the same time.
+	 * \arg		grid	state whose solutions are enumerated
+	 * \arg		visitor	function receiving each solution; it returns false to stop
+	 * \arg		context	argument given to the visitor
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to visit them all
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	number of solutions visited
+	 */
+	unsigned long Search::enumerate(const Grid& grid, tVisitor visitor, void* context, unsigned long limit,
+		short unsigned int threads)
+	{
+		Budget unlimited;
+
+		return enumerate(grid, visitor, context, unlimited, limit, threads);
+	}
+
+	/**
+	 * Enumerates the solutions of a grid within a budget, handing each of them to a visitor.
+	 * \arg		grid	state whose solutions are enumerated
+	 * \arg		visitor	function receiving each solution; it returns false to stop
+	 * \arg		context	argument given to the visitor
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to visit them all
+	 * \arg		threads	number of threads to use, or 0 to use one per processor
+	 * \return	number of solutions visited
+	 */
+	unsigned long Search::enumerate(const Grid& grid, tVisitor visitor, void* context, Budget& budget,
+		unsigned long limit, short unsigned int threads)
+	{
+		SUDOKU_TRACE_SPAN("enumerate");
+
+		if(threads == 0)
+			threads = cores();
+
+		if(threads == 1) {
+			unsigned long found = 0;
+
+			walk(grid, visitor, context, limit, found, budget);
+			return found;
+		}
+
+		SearchJob job(threads, true, limit, budget, visitor, context);
+		run(job, grid);
+
+		return job.total();
+	}
+}
+}
@@ -0,0 +1,164 @@
+// See COPYING file for licensing information.
+/**
+ * \file search.h
+ * Definition of the backtracking search used to solve any sudoku board, either
+ * sequentially or splitting its subtrees among several threads.
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "sudoku.h"
+#include "budget.h"
+#include <deque>
+#include <pthread.h>
+
+namespace std {
+namespace sudoku {
+	class SearchJob;
+	class Grid;
+
+	/**
+	 * Function receiving the solutions of an enumeration, with the context given to it.
+	 * It returns false to stop the enumeration.
+	 */
+	typedef bool (*tVisitor)(const Grid& solution, void* context);
+
+	/**
+	 * Alternatives of a branch of the search: each child assigns one of the values to its cell.
+	 */
+	typedef struct {
+		short unsigned int Cells[9];
+		short unsigned int Values[9];
+		short unsigned int Count;
+	} Branch;
+
+	/**
+	 * Compact candidates state of a sudoku board.
+	 * Each cell keeps its candidates as a bitmask (bit v - 1 is set if v is still possible) so that
+	 * the whole state is cheap to copy in every branch of the search. Contradictions are the normal
+	 * case while searching, so instead of throwing the Grid methods just return false.
+	 * The state is also identified by a Zobrist key, updated by every value set and every candidate
+	 * removed from outside, since the rest of the state follows from them.
+	 * Every removal also keeps up to date, for the choice of the next branch without looking at every
+	 * cell, the undecided cells by number of candidates (a bitset of the 81 cells per number), the
+	 * number of places of each value in each unit, and the units with a value in exactly two places.
+	 */
+	class Grid {
+		short unsigned int Candidates[81];
+		short unsigned int Values[81];
+		short unsigned int Unsolved;
+		unsigned long long Key;
+		unsigned long long Buckets[10][2];
+		unsigned long long Pairs[4];
+		unsigned char Places[27][9];
+
+		friend class Search;
+
+		bool exclude(short unsigned int cell, short unsigned int myP);
+		void refile(short unsigned int cell, short unsigned int from, short unsigned int to);
+
+	public:
+		Grid();
+
+		bool load(Board& Sudoku);
+		void store(Board& Sudoku) const;
+		bool assign(short unsigned int cell, short unsigned int myP);
+		bool eliminate(short unsigned int cell, short unsigned int myP);
+		short unsigned int choose() const;
+		void branch(Branch& branch) const;
+		short unsigned int get(short unsigned int cell) const;
+		short unsigned int getCandidates(short unsigned int cell) const;
+		bool isSolved() const;
+		unsigned long long getKey() const;
+	};
+
+	/**
+	 * Result of a subtree of the search kept in a TranspositionTable: its number of solutions,
+	 * which is only a lower bound if the subtree wasn't fully explored.
+	 */
+	typedef struct {
+		unsigned long long Key;
+		unsigned long Count;
+		short unsigned int Unsolved;
+		bool Exact;
+	} Transposition;
+
+	/**
+	 * Cache of the results of the subtrees already explored, indexed by the key of their Grid, so
+	 * that a state reached again through another order of the branches isn't explored again.
+	 * Its memory is fixed when it's built. Each bucket has two entries: the first one keeps the
+	 * biggest subtree stored there, the second one the latest. A table can't be shared by several
+	 * threads, so it's only used by the sequential searches.
+	 */
+	class TranspositionTable {
+		Transposition* Entries;
+		size_t Mask;
+		unsigned long Probes, Hits;
+
+		TranspositionTable(const TranspositionTable& copy);
+
+	public:
+		TranspositionTable(size_t bytes = 4 << 20);
+		~TranspositionTable();
+
+		bool probe(unsigned long long key, unsigned long& count, bool& exact);
+		void store(unsigned long long key, unsigned long count, bool exact, short unsigned int unsolved);
+		void clear();
+		unsigned long getProbes() const;
+		unsigned long getHits() const;
+	};
+
+	/**
+	 * Double-ended queue of pending subtrees owned by one search thread.
+	 * Its owner pushes and pops subtrees at the bottom, so it keeps exploring depth first, while
+	 * idle threads steal from the top the oldest subtrees, which are also the biggest ones.
+	 */
+	class WorkQueue {
+		deque<Grid> Tasks;
+		pthread_mutex_t Lock;
+
+		WorkQueue(const WorkQueue& copy);
+
+	public:
+		WorkQueue();
+		~WorkQueue();
+
+		void push(const Grid& grid);
+		bool pop(Grid& grid);
+		bool steal(Grid& grid);
+	};
+
+	class Search {
+		Search();
+
+		static bool first(Grid& grid, Budget& budget, TranspositionTable* table = 0);
+		static void tally(const Grid& grid, unsigned long limit, unsigned long& found, Budget& budget,
+			TranspositionTable* table = 0);
+		static bool walk(const Grid& grid, tVisitor visitor, void* context, unsigned long limit,
+			unsigned long& found, Budget& budget);
+		static void explore(Grid& grid, SearchJob& job, WorkQueue& own);
+		static void* worker(void* job);
+		static void run(SearchJob& job, const Grid& grid);
+	public:
+		static short unsigned int cores();
+		static bool solve(Grid& grid, short unsigned int threads = 1);
+		static bool solve(Board& Sudoku, short unsigned int threads = 1);
+		static unsigned long count(const Grid& grid, unsigned long limit = 0, short unsigned int threads = 1);
+		static unsigned long count(Board& Sudoku, unsigned long limit = 0, short unsigned int threads = 1);
+		static bool solve(Grid& grid, Budget& budget, short unsigned int threads = 1);
+		static bool solve(Board& Sudoku, Budget& budget, short unsigned int threads = 1);
+		static unsigned long count(const Grid& grid, Budget& budget, unsigned long limit = 0, short unsigned int threads = 1);
+		static unsigned long count(Board& Sudoku, Budget& budget, unsigned long limit = 0, short unsigned int threads = 1);
+		static bool solve(Grid& grid, TranspositionTable& table);
+		static bool solve(Grid& grid, TranspositionTable& table, Budget& budget);
+		static unsigned long count(const Grid& grid, TranspositionTable& table, unsigned long limit = 0);
+		static unsigned long count(const Grid& grid, TranspositionTable& table, Budget& budget, unsigned long limit = 0);
+		static unsigned long enumerate(const Grid& grid, tVisitor visitor, void* context, unsigned long limit = 0,
+			short unsigned int threads = 1);
+		static unsigned long enumerate(const Grid& grid, tVisitor visitor, void* context, Budget& budget,
+			unsigned long limit = 0, short unsigned int threads = 1);
+	};
+}
+}
+#endif
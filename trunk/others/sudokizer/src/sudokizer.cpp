@@ -21,17 +21,333 @@
  */
 
 #include "sudoku.h"
+#include "search.h"
+#include "sat.h"
+#include "backjump.h"
+#include "portfolio.h"
+#include "render.h"
+#include "parser.h"
+#include "trace.h"
 #include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace sudoku;
 
+/**
+ * Output of the solutions streamed by the command line mode: they are formatted into a buffer
+ * which is written out whenever it can't hold another one.
+ */
+typedef struct {
+	char Buffer[65536];
+	size_t Length;
+} Output;
+
+/**
+ * Makes room in the output for another board, writing out what it holds if needed.
+ */
+static bool reserve(Output& out) {
+	if(sizeof(out.Buffer) - out.Length < Render::size(oneline)) {
+		if(!Render::emit(1, out.Buffer, out.Length))
+			return false;
+		out.Length = 0;
+	}
+
+	return true;
+}
+
+/**
+ * Visitor writing every solution as a line of 81 digits.
+ */
+static bool print(const Grid& solution, void* context) {
+	Output& out = *static_cast<Output*>(context);
+
+	if(!reserve(out))
+		return false;
+
+	out.Length += Render::format(solution, oneline, out.Buffer + out.Length, sizeof(out.Buffer) - out.Length);
+	return true;
+}
+
+/**
+ * Visitor only counting the solutions, which the enumeration does on its own.
+ */
+static bool skip(const Grid&, void*) {
+	return true;
+}
+
+/**
+ * Prints the command line usage.
+ */
+static int usage(const char* name) {
+	cerr << "usage: " << name << " [-e search|sat|backjump|logic|portfolio] [-a | -c] [-n limit] [-j threads] [-t trace] puzzle" << endl
+		<< "       " << name << " [options] -f file" << endl
+		<< "  puzzle      81 characters, row by row: 1 to 9 for the givens, 0 or . for the empty cells" << endl
+		<< "  -f file     solve every puzzle of a file, - for the standard input; lines of 81 cells," << endl
+		<< "              grids as the game shows them, SadMan (.sdk) and Simple Sudoku (.ss) files" << endl
+		<< "              are read" << endl
+		<< "  -e engine   backtracking search (default), SAT solver, search with backjumping, logic" << endl
+		<< "              only (no guessing), or a race of all of them" << endl
+		<< "  -a          print every solution, one per line" << endl
+		<< "  -c          only print the number of solutions" << endl
+		<< "  -n limit    stop after this number of solutions" << endl
+		<< "  -j threads  threads for the search engine, 0 for one per processor" << endl
+		<< "  -t trace    write the timeline of the solver phases to this Chrome trace file; only" << endl
+		<< "              builds made with scons trace=1 record it" << endl;
+	return 2;
+}
+
+/**
+ * Reads a whole file into memory.
+ * \arg		path	the file, or "-" for the standard input
+ * \arg		text	set to the contents of the file
+ * \return	false if it couldn't be read
+ */
+static bool slurp(const char* path, vector<char>& text) {
+	int fd = strcmp(path, "-") == 0 ? 0 : open(path, O_RDONLY);
+	char buffer[65536];
+	ssize_t got;
+
+	if(fd < 0)
+		return false;
+
+	text.clear();
+	while((got = read(fd, buffer, sizeof(buffer))) != 0) {
+		if(got < 0 && errno == EINTR)
+			continue;
+		if(got < 0)
+			break;
+		text.insert(text.end(), buffer, buffer + got);
+	}
+
+	if(fd != 0)
+		close(fd);
+	return got == 0;
+}
+
+/**
+ * Solves, enumerates or counts the solutions of a puzzle, appending them to the output.
+ * \arg		engine		name of the engine
+ * \arg		values		the 81 cells, 0 for the empty ones
+ * \arg		all			whether every solution is printed
+ * \arg		counting	whether only the number of solutions is printed
+ * \arg		limit		maximum number of solutions, 0 for no limit
+ * \arg		threads		threads for the search engine
+ * \arg		out			output of the solutions
+ * \arg		stuck		set to whether the logic engine stopped before the end without finding the
+ *						puzzle wrong, that is, needing to guess
+ * \return	number of solutions found, or 0 if the output couldn't be written
+ */
+static unsigned long run(const char* engine, const short unsigned int* values, bool all, bool counting,
+	unsigned long limit, short unsigned int threads, Output& out, bool& stuck)
+{
+	Grid grid;
+	bool valid = true;
+
+	stuck = false;
+	for(short unsigned int c = 0; c < 81 && valid; c++)
+		if(values[c] != 0)
+			valid = grid.assign(c, values[c]);
+
+	if(strcmp(engine, "logic") == 0 || strcmp(engine, "portfolio") == 0) {
+		Board Sudoku;
+		bool solved = valid;
+
+		for(short unsigned int c = 0; c < 81 && solved; c++)
+			if(values[c] != 0)
+				solved = Sudoku.place(c / 9, c % 9, values[c]);
+
+		if(strcmp(engine, "logic") == 0) {
+			try {
+				if(solved)
+					Solver::resolve(Sudoku);
+			} catch(...) {
+				solved = false;
+			}
+		} else if(solved) {
+			Portfolio portfolio;
+
+			solved = portfolio.solve(Sudoku);
+		}
+
+		if(!solved)
+			return 0;
+
+		// The logic engine prints how far it got, even if it had to stop before the end
+		if(!reserve(out))
+			return 0;
+		out.Length += Render::format(Sudoku, oneline, out.Buffer + out.Length, sizeof(out.Buffer) - out.Length);
+		stuck = Sudoku.getState() != definitive;
+		return stuck ? 0 : 1;
+	}
+
+	unsigned long found = 0;
+	Budget budget;
+
+	if(!valid)
+		found = 0;
+	else if(counting && strcmp(engine, "search") == 0)
+		found = Search::count(grid, limit, threads);
+	else if(strcmp(engine, "search") == 0)
+		found = Search::enumerate(grid, print, &out, budget, all ? limit : 1, threads);
+	else if(strcmp(engine, "backjump") == 0)
+		found = Backjumper::solve(grid, budget) && print(grid, &out) ? 1 : 0;
+	else
+		found = SatSolver::enumerate(grid, counting ? skip : print, &out, budget, (all || counting) ? limit : 1);
+
+	if(counting) {
+		if(!reserve(out))
+			return 0;
+		out.Length += snprintf(out.Buffer + out.Length, sizeof(out.Buffer) - out.Length, "%lu\n", found);
+	}
+
+	return found;
+}
+
+/**
+ * Command line mode: solves, enumerates or counts the solutions of the puzzle given as argument,
+ * or of every puzzle of a file.
+ * \return	exit status: 0 if every puzzle has a solution, 1 if one hasn't, 2 for a usage error, 3 if
+ *			the logic engine got stuck on one, which needs guessing, and the others have a solution
+ */
+static int command(int argc, char** argv) {
+	const char* engine = "search";
+	const char* file = 0;
+	const char* trace = 0;
+	bool all = false, counting = false;
+	unsigned long limit = 0;
+	short unsigned int threads = 1;
+	int option;
+
+	while((option = getopt(argc, argv, "e:acn:j:f:t:")) != -1) {
+		switch(option) {
+			case 'e':
+				engine = optarg;
+				break;
+			case 'a':
+				all = true;
+				break;
+			case 'c':
+				counting = true;
+				break;
+			case 'n':
+				limit = strtoul(optarg, 0, 10);
+				break;
+			case 'j': {
+				// digits only, as strtoul would take a sign and wrap a negative count around
+				char* end;
+				unsigned long count = strtoul(optarg, &end, 10);
+
+				if(*optarg < '0' || *optarg > '9' || *end != '\0' || count > 0xFFFF)
+					return usage(argv[0]);
+				threads = static_cast<short unsigned int>(count);
+				break;
+			}
+			case 'f':
+				file = optarg;
+				break;
+			case 't':
+				trace = optarg;
+				break;
+			default:
+				return usage(argv[0]);
+		}
+	}
+
+	if(optind != argc - (file ? 0 : 1) || (all && counting))
+		return usage(argv[0]);
+	if(!file && strlen(argv[optind]) != 81)
+		return usage(argv[0]);
+	if(strcmp(engine, "search") != 0 && strcmp(engine, "sat") != 0 && strcmp(engine, "backjump") != 0
+		&& strcmp(engine, "logic") != 0 && strcmp(engine, "portfolio") != 0)
+		return usage(argv[0]);
+
+	if((strcmp(engine, "logic") == 0 || strcmp(engine, "backjump") == 0 || strcmp(engine, "portfolio") == 0)
+		&& (all || counting)) {
+		cerr << argv[0] << ": the " << engine << " engine finds at most one solution" << endl;
+		return 2;
+	}
+
+	if(trace && !Trace::enabled()) {
+		cerr << argv[0] << ": this build doesn't record the timeline, build it with scons trace=1" << endl;
+		return 2;
+	}
+
+	vector<char> text;
+
+	if(!file)
+		text.assign(argv[optind], argv[optind] + 81);
+	else if(!slurp(file, text)) {
+		cerr << argv[0] << ": can't read " << file << endl;
+		return 2;
+	}
+
+	Parser parser(text.empty() ? "" : &text[0], text.size());
+	short unsigned int values[81];
+	unsigned long puzzles = 0, failed = 0, stuck = 0;
+	Output out;
+
+	out.Length = 0;
+
+	while(parser.next(values)) {
+		bool guessing;
+
+		puzzles++;
+		if(run(engine, values, all, counting, limit, threads, out, guessing) == 0 && !counting) {
+			const char* reason = guessing ? "stuck, needs guessing" : "no solution";
+
+			if(guessing)
+				stuck++;
+			else
+				failed++;
+			if(file)
+				cerr << "puzzle " << puzzles << ": " << reason << endl;
+			else
+				cerr << reason << endl;
+		}
+	}
+
+	if(!Render::emit(1, out.Buffer, out.Length))
+		return 1;
+
+	if(trace && !Trace::save(trace)) {
+		cerr << argv[0] << ": can't write " << trace << endl;
+		return 2;
+	}
+
+	if(puzzles == 0) {
+		if(!file)
+			return usage(argv[0]);
+		cerr << argv[0] << ": no puzzle found in " << file << endl;
+		return 2;
+	}
+	if(parser.getSkipped() > 0)
+		cerr << argv[0] << ": " << parser.getSkipped() << " lines of " << file << " skipped, read as "
+			<< Parser::name(parser.getInput()) << " format" << endl;
+
+	if(file && stuck > 0)
+		cerr << argv[0] << ": " << stuck << " of " << puzzles << " puzzles need guessing, which the "
+			<< engine << " engine doesn't do" << endl;
+
+	return failed > 0 ? 1 : stuck > 0 ? 3 : 0;
+}
+
 /**
  * Main program loop.
+ * With arguments it runs the command line mode instead of generating a game.
  * \param	argc	number of command line arguments
  * \param	argv	list of arguments
  */
 int main(int argc, char** argv) {
+		if(argc > 1)
+			return command(argc, argv);
+		
 		
 // 		Board game;
 // 		
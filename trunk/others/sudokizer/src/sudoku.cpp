@@ -4,9 +4,13 @@
  * Implementation of the classes needed for a sudoku game.
  */
 #include "sudoku.h"
+#include "render.h"
+#include "tables.h"
+#include "budget.h"
+#include "trace.h"
 #include <iostream>
-#include <string>
 #include <cstdlib>
+#include <cstring>
 
 namespace std {
 namespace sudoku {
@@ -17,7 +21,7 @@ namespace sudoku {
 	* If it's 0, all the range [1,9] will be added automatically the posibilities list
 	* \arg		S	initial state. optional argument, set to undecided by default
 	*/
-	inline Cell::Cell(short unsigned int P, state S)
+	Cell::Cell(short unsigned int P, state S)
 		: State(S)
 	{
 		if(P > 0) {
@@ -38,7 +42,7 @@ namespace sudoku {
 	 * Cell copy function
 	 * \arg	copy	Reference to the cell to copy
 	 */
-	inline void Cell::copy(const Cell& copy)
+	void Cell::copy(const Cell& copy)
 	{
 		State = copy.State;
 		
@@ -50,7 +54,7 @@ namespace sudoku {
 	 * Cell copy function
 	 * \arg	copy	Reference to the cell to copy
 	 */
-	inline Cell::Cell(const Cell& copy)
+	Cell::Cell(const Cell& copy)
 	{
 		State = copy.State;
 		
@@ -61,7 +65,7 @@ namespace sudoku {
 	/**
 	 * Cell copy destructor
 	 */
-	inline Cell::~Cell() {
+	Cell::~Cell() {
 	}
 	
 	/**
@@ -70,7 +74,7 @@ namespace sudoku {
 	* \arg		myP				Value to check
 	* \throw	domain_error	Thrown if an argument not within the range [1,9] is provided
 	*/
-	void Cell::check(short unsigned int myP) throw(domain_error) {
+	void Cell::check(short unsigned int myP) {
 		if(myP >= 10 || myP == 0)
 			throw domain_error("possibilities can only be in a range of short unsigned integers [1,9], " \
 			"but it was attempted to use 0 or one of value over 9");
@@ -83,14 +87,15 @@ namespace sudoku {
 	* \arg		myP				the value to remove
 	* \throw	logic_error		Thrown if cell state is undecided instead of definitive
 	*/
-	void Cell::fastDelPossibility(short unsigned int myP) throw(logic_error) {
-		for(int i = 0; i < 10; i++) {
+	void Cell::fastDelPossibility(short unsigned int myP) {
+		for(int i = 0; i < 9; i++) {
 			if(Possibilities[i] == 0)
 				return;
 			else if (Possibilities[i] == myP) {
-				// Eliminate this value and shift to the left the remaining ones
+				// Eliminate this value and shift to the left the remaining ones; a full list has no
+				// terminating zero, so its end stops the shift too
 				for(; i < 9; i++) {
-					if(Possibilities[i + 1] == 0) {
+					if(i == 8 || Possibilities[i + 1] == 0) {
 						Possibilities[i] = 0;
 						
 						// If it's the only element left, automatically set it to definitive
@@ -116,7 +121,7 @@ namespace sudoku {
 	* \arg		myP				the value to add
 	*/
 	void Cell::fastAddPossibility(short unsigned int myP) {
-		for(int i = 0; i < 10; i++) {
+		for(int i = 0; i < 9; i++) {
 			// - If a possibility is set to 0, as it is by default, it means there are no more of them
 			// in the rest of the array
 			if(Possibilities[i] == 0) {
@@ -133,7 +138,7 @@ namespace sudoku {
 	* \return 	true if the given value is in the posibilities list, or false if not.
 	*/
 	bool Cell::fastIsPossible(short unsigned int myP) const {
-		for(int i = 0; i < 10; i++) {
+		for(int i = 0; i < 9; i++) {
 			if(Possibilities[i] == 0)
 				return false;
 			else if (Possibilities[i] == myP)
@@ -156,6 +161,24 @@ namespace sudoku {
 		return true;
 	}
 	
+	/**
+	* Removes a given value from the possibilities list without checking the given value validity.
+	* Unlike fastDelPossibility, the cell state is never changed, even if a single possibility
+	* or none is left.
+	* \arg		myP				the value to remove
+	*/
+	void Cell::fastRemove(short unsigned int myP) {
+		for(int i = 0; i < 9 && Possibilities[i] != 0; i++) {
+			if(Possibilities[i] == myP) {
+				// Shift to the left the remaining ones
+				for(; i < 8; i++)
+					Possibilities[i] = Possibilities[i + 1];
+				Possibilities[8] = 0;
+				return;
+			}
+		}
+	}
+	
 	/**
 	* Sets the definitive value of the cell.
 	* \arg		myP				the value to set
@@ -166,20 +189,13 @@ namespace sudoku {
 		Possibilities[1] = 0; // the list "ends" in the first element set to zero
 	}
 	
-	/**
-	* Returns the available possibilities to the user.
-	*/
-	inline short unsigned int* Cell::getPossibilities() {
-		return Possibilities;
-	}
-	
 	/**
 	* Adds a given possibility to the list.
 	* Adds the given value to the possibilities list if it's not there already.
 	* \arg		myP				the value to add
 	* \throw	domain_error	Thrown if myP is not within the range [1,9]
 	*/
-	void Cell::addPossibility(short unsigned int myP) throw(domain_error) {
+	void Cell::addPossibility(short unsigned int myP) {
 		
 		check(myP); // this can throw domain_error
 		
@@ -192,7 +208,7 @@ namespace sudoku {
 	* \throw	domain_error	Thrown if myP is not within the range [1,9], and also thrown if
 	* we try to set a value which is not part of the possibilities list
 	*/
-	inline void Cell::set(short unsigned int myP) throw(domain_error) {
+	void Cell::set(short unsigned int myP) {
 	
 		check(myP); // this can throw domain_error
 		
@@ -212,7 +228,7 @@ namespace sudoku {
 	* \return	Returns the definitive value of the cell
 	* \throw	logic_error		Thrown if cell state is undecided instead of definitive
 	*/
-	inline short unsigned int Cell::get() throw(logic_error) {
+	short unsigned int Cell::get() {
 		if(State == definitive)
 			return Possibilities[0];
 		else
@@ -226,7 +242,7 @@ namespace sudoku {
 	* \arg		myP				the value to remove
 	* \throw 	logic_error		Thrown if no possibility is left, all of them were deleted
 	*/
-	void Cell::delPossibility(short unsigned int myP) throw(logic_error) {
+	void Cell::delPossibility(short unsigned int myP) {
 		try {
 			check(myP);
 		} catch(...) {
@@ -252,21 +268,12 @@ namespace sudoku {
  		return fastIsPossible(myP);
 	}
 	
-	/**
-	* Returns current Cell state.
-	* It can be either undecided or definitive.
-	* \return Current cell state.
-	*/
-	inline state Cell::getState() const {
-		return State;
-	}
-	
 	/**
 	* Sets cell state.
 	* It can be set to either undecided or definitive.
 	* \arg	cell state to be set
 	*/
-	inline void Cell::setState(state S) {
+	void Cell::setState(state S) {
 		
 		// Clean the possiblities list if needed
 		if(State == definitive && S == undecided)
@@ -283,7 +290,7 @@ namespace sudoku {
 	/**
 	* Cell brought to the broadest state: state undecided and all possibilities.
 	*/
-	inline void Cell::erase() {
+	void Cell::erase() {
 		State = undecided;
 		
 		for(int i = 0; i < 9; i++)
@@ -297,7 +304,7 @@ namespace sudoku {
 	*	have the requested 'x' index.
 	* \throw	domain_error	Thrown if 'i' argument is not within the range [0,2]
 	*/
-	Cell** Box::operator[] (short unsigned int i) throw(domain_error) {
+	Cell** Box::operator[] (short unsigned int i) {
 		if(i < 3)
 			return elements[i];
 		else
@@ -312,7 +319,7 @@ namespace sudoku {
 	* \arg		myP				the value to remove
 	 * \throw 	logic_error		Thrown if no possibility is left in any of the cells
 	*/
-	void Box::delPossibility(short unsigned int myP, Cell &cell) throw(logic_error) {
+	void Box::delPossibility(short unsigned int myP, Cell &cell) {
 		try {
 			Cell::check(myP);
 		} catch(...) {
@@ -394,15 +401,6 @@ namespace sudoku {
 		return elements;
 	}
 	
-	/**
-	* Deletes the list of pointers to Cells correspoding to the Line elements, which
-	* should had been previously dynamically allocated and should not to have been deallocated yet.
-	*/
-	void Line::deleteAll() {
-		for(short unsigned int i = 0; i < 9; i++)
-			delete elements[i];
-	}
-	
 	/**
 	* Removes a given value from the possibilities list of every cell in the Line but a given cell.
 	* Removes the given value from the possibilities lists if it's in there.
@@ -411,7 +409,7 @@ namespace sudoku {
 	* \arg		cell	Cell reference to the cell not to update
 	 * \throw 	logic_error		Thrown if no possibility is left in any of the cells
 	*/
-	void Line::delPossibility(short unsigned int myP, Cell& cell) throw(logic_error) {
+	void Line::delPossibility(short unsigned int myP, Cell& cell) {
 		try {
 			Cell::check(myP);
 		} catch(...) {
@@ -437,7 +435,7 @@ namespace sudoku {
 			return;
 		}
 		
-		for(int i = 0; i < 3; i++)
+		for(int i = 0; i < 9; i++)
 			elements[i]->fastAddPossibility(myP);
 	}
 	
@@ -488,77 +486,104 @@ namespace sudoku {
 	 * \throw	domain_error If the index is not within the range [0,8]
 	 * \return	Using the copy constructor, copies
 	 */
-	Cell Line::copy(short unsigned int i) const throw(domain_error) {
+	Cell Line::copy(short unsigned int i) const {
 		Cell::check(i - 1);
 		
 		Cell c = *elements[i];
 		return c;
 	}
 	
+	/**
+	 * Returns an identity which no other board has had. The versions of every board count from
+	 * the same values, so the caches which follow a board need both to recognise it.
+	 */
+	static unsigned long identify() {
+		static volatile unsigned long last = 0;
+		
+		return __sync_add_and_fetch(&last, 1);
+	}
+	
 	/**
 	* Constructor for a sudoku Board.
 	* Initialises the lists of columns, rows and boxes with empty dynamically allocated Cells.
 	* Note that each cell is pointed by one column, one row and one box.
 	*/
-	Board::Board() {
-		for(short unsigned int i = 0, ii = 0, I = 0; I < 9; I++, (I % 3 == 0) ? i++ : i, ii = I % 3) {
-			for(short unsigned int j = 0, jj = 0, J = 0; J < 9; J++, (J % 3 == 0) ? j++ : j, jj = J % 3) {
- 				Boxes[i][j][ii][jj] = new Cell();
- 				Rows[I][J] = Boxes[i][j][ii][jj];
- 				Cols[J][I] = Rows[I][J];
-			}
-		}
+	Board::Board()
+		: Storage(new Cell[81]), Identity(identify()), Version(0)
+	{
+		for(short unsigned int c = 0; c < 81; c++)
+			link(c, &Storage[c]);
+		
+		for(short unsigned int u = 0; u < 27; u++)
+			for(short unsigned int p = 0; p < 9; p++)
+				Counts[u][p] = 0;
 	}
+	
 	/**
 	 * Constructor for a random sudoku board.
 	 * Creates randomly a solveable game.
 	 * \arg	solution	Board where the solution to this random game will be stored
 	 * \arg	solvedCells	Nomber of cells solved in the created game
 	 */
-	Board::Board(Board* solution, short unsigned int solvedCells) {
-		bool iterate = true;
-		short unsigned int tolerance = 30;
+	Board::Board(Board* solution, short unsigned int solvedCells)
+		: Storage(new Cell[81]), Identity(identify()), Version(0)
+	{
+		Budget unlimited;
 		
 		// initialize the cells
-		for(short unsigned int i = 0, ii = 0, I = 0; I < 9; I++, (I % 3 == 0) ? i++ : i, ii = I % 3) {
-			for(short unsigned int j = 0, jj = 0, J = 0; J < 9; J++, (J % 3 == 0) ? j++ : j, jj = J % 3) {
- 				Rows[I][J] = new Cell();
- 				Boxes[i][j][ii][jj] = Rows[I][J];
- 				Cols[J][I] = Rows[I][J];
-			}
-		}
+		for(short unsigned int c = 0; c < 81; c++)
+			link(c, &Storage[c]);
+		
+		fill(solution, solvedCells, unlimited);
+	}
+	
+	/**
+	 * Creates randomly a solveable game in the board, for the random board constructor and for
+	 * generate(). A node is spent for every cell set and every pass of the solver checking the game.
+	 */
+	bool Board::fill(Board* solution, short unsigned int solvedCells, Budget& budget) {
+		SUDOKU_TRACE_SPAN("generate");
+		bool iterate = true;
+		short unsigned int tolerance = 30;
 		
 		// In each iteration, a potential "game" is created from scratch (a clean board), and the loop
 		// iterates till it creates a solveable game
-		while(iterate) {
+		while(iterate && !budget.exceeded()) {
 			// Erase board cells
-			for(short unsigned I = 0; I < 9; I++)
-				for(short unsigned int J = 0; J < 9; J++)
- 					Rows[I][J]->erase();
+			for(short unsigned int c = 0; c < 81; c++)
+				at(c).erase();
 			
 			short unsigned int state = 0;
-			bool solved;
+			bool solved = true;
 			
 			// Set a cell a new cell is set to definitive state
 			while(state < solvedCells) {
-				short unsigned int I, J, i, j, val;
+				short unsigned int c, val, left = 0;
+				
+				solved = false;
+				if(!budget.spend())
+					break;
+				
+				// The cells made definitive while setting others count too, so they may run out
+				for(c = 0; c < 81; c++)
+					if(at(c).getState() == undecided)
+						left++;
+				
+				if(left == 0)
+					break;
 				
 				// Pseudo randomly Locate an undecided cell
 				do {
-					I = Generator::nextValue(9,0);
-					J = Generator::nextValue(9,0);
-					i = I / 3;
-					j = J / 3;
-				} while (Rows[I][J]->getState());
+					c = Generator::nextValue(81,0);
+				} while (at(c).getState());
 				
 				short unsigned int tries = 0;
-				solved = false;
 				
 				// Try <tolerance> times to solve it with randomly generated values
 				do {
 					tries++;
 					val = Generator::nextValue();
-					solved = Generator::solveCell(*Rows[I][J], Rows[I], Cols[J], Boxes[i][j], val);
+					solved = Generator::solveCell(*this, c, val);
 				} while (!solved && tries < tolerance);
 				
 				
@@ -579,48 +604,334 @@ namespace sudoku {
 			// from scratch.  But ff it's a valid game this constructor has finished
 			// its  task
 			if(solved) {
-				for(short unsigned int I = 0; I < 9; I++)
-					for(short unsigned int J = 0; J < 9; J++)
-						solution->Rows[I][J]->copy(*Rows[I][J]);
+				for(short unsigned int c = 0; c < 81; c++)
+					solution->at(c).copy(at(c));
 				
 				try {
-					Solver::resolve(*solution); // this might throw some exceptions if the game is unsolveable
-					
-					// Valid game found!
-					if (solution->getState() == definitive)
-						iterate = false;
+					// this might throw some exceptions if the game is unsolveable
+					if(Solver::resolve(*solution, budget) && solution->getState() == definitive)
+						iterate = false; // Valid game found!
 				} catch (...) {
 					// Exceptions thrown -> game unsolveable -> reiterate -> Erase the board and reiterate
 				}
 			}
+			
+			// The value tells how many cells were set before giving up; all of them if it was
+			// the solver which found the game unsolveable
+			if(iterate)
+				SUDOKU_TRACE_EVENT("generator restart", state);
 		}
+		
+		if(iterate) {
+			for(short unsigned int c = 0; c < 81; c++)
+				at(c).erase();
+		}
+		
+		recount();
+		return !iterate;
+	}
+	
+	/**
+	 * Creates randomly a solveable game in the board, as the random board constructor does, but
+	 * giving up once the budget is exceeded.
+	 * \arg	solution	Board where the solution to this random game will be stored
+	 * \arg	solvedCells	Nomber of cells solved in the created game
+	 * \arg	budget		limits of the generation
+	 * \return	false if the budget was exceeded, in which case the board is left empty
+	 */
+	bool Board::generate(Board* solution, short unsigned int solvedCells, Budget& budget) {
+		return fill(solution, solvedCells, budget);
 	}
 	
 	/**
 	 * Copy-Constructor for a sudoku Board. Creates an exact copy of the given one.
 	 * \arg	copy	Reference to the board to copy
 	 */
-	Board::Board(const Board& copy) {
-		for(short unsigned int i = 0, ii = 0, I = 0; I < 9; I++, (I % 3 == 0) ? i++ : i, ii = I % 3) {
-			for(short unsigned int j = 0, jj = 0, J = 0; J < 9; J++, (J % 3 == 0) ? j++ : j, jj = J % 3) {
-				const Line l = copy.Rows[I];
-				Cell c = l.copy(J);
- 				Boxes[i][j][ii][jj] = new Cell(c);
- 				Rows[I][J] = Boxes[i][j][ii][jj];
- 				Cols[J][I] = Rows[I][J];
-			}
+	Board::Board(const Board& copy)
+		: Storage(new Cell[81]), Journal(copy.Journal), Identity(identify()), Version(copy.Version)
+	{
+		for(short unsigned int c = 0; c < 81; c++) {
+			Storage[c].copy(*copy.Cells[c]);
+			link(c, &Storage[c]);
 		}
+		
+		memcpy(Counts, copy.Counts, sizeof(Counts));
 	}
 	
+	/**
+	 * Move-Constructor for a sudoku Board. Takes the cells of the given one, which is left
+	 * without them: its pointers null and its counts zero, from the members of this one.
+	 * \arg	other	Reference to the board to move
+	 */
+	Board::Board(Board&& other) noexcept
+		: Storage(0), Cells(), Cols(), Rows(), Boxes(), Counts(), Identity(0), Version(0)
+	{
+		swap(other);
+	}
 	
 	/**
 	* Destructor fro a sudoku Board.
-	* Dynamically deallocate Board cells, which had been allocated in the constructor call.
+	* Deallocates the block of cells allocated in the constructor call.
 	*/
 	Board::~Board() {
-		for(short unsigned int i = 0; i < 10; i++) {
- 			Rows[i].deleteAll();
+		delete[] Storage;
+	}
+	
+	/**
+	 * Copies another board into this one, reusing the cells of this one if it has any.
+	 * \arg	copy	Reference to the board to copy
+	 * \return	this board
+	 */
+	Board& Board::operator=(const Board& copy) {
+		if(this == &copy)
+			return *this;
+		
+		if(Storage == 0) {
+			Storage = new Cell[81];
+			for(short unsigned int c = 0; c < 81; c++)
+				link(c, &Storage[c]);
 		}
+		
+		for(short unsigned int c = 0; c < 81; c++)
+			Storage[c].copy(*copy.Cells[c]);
+		
+		memcpy(Counts, copy.Counts, sizeof(Counts));
+		Journal = copy.Journal;
+		Identity = identify();
+		Version = copy.Version;
+		return *this;
+	}
+	
+	/**
+	 * Moves another board into this one, which gives its cells to the other one in exchange.
+	 * \arg	other	Reference to the board to move
+	 * \return	this board
+	 */
+	Board& Board::operator=(Board&& other) noexcept {
+		swap(other);
+		return *this;
+	}
+	
+	/**
+	 * Exchanges the state of two boards. The rows, columns and boxes keep pointing to the cells
+	 * they had, which now belong to the other board, so exchanging them is enough.
+	 * \arg	other	Reference to the other board
+	 */
+	void Board::swap(Board& other) noexcept {
+		std::swap(Storage, other.Storage);
+		std::swap(Cells, other.Cells);
+		std::swap(Cols, other.Cols);
+		std::swap(Rows, other.Rows);
+		std::swap(Boxes, other.Boxes);
+		std::swap(Counts, other.Counts);
+		Journal.swap(other.Journal);
+		std::swap(Identity, other.Identity);
+		std::swap(Version, other.Version);
+	}
+	
+	/**
+	 * Places a cell in the board, making the row, the column and the box where it belongs point to it.
+	 * \arg	c		index of the cell within the board, in the range [0,80]
+	 * \arg	cell	the cell to place
+	 */
+	void Board::link(short unsigned int c, Cell* cell) {
+		short unsigned int box = CellUnits[c][2] - 18, inBox = UnitIndexes[c][2];
+		
+		Cells[c] = cell;
+		Rows[CellUnits[c][0]][UnitIndexes[c][0]] = cell;
+		Cols[CellUnits[c][1] - 9][UnitIndexes[c][1]] = cell;
+		Boxes[box / 3][box % 3][inBox / 3][inBox % 3] = cell;
+	}
+	
+	/**
+	 * Returns the cell with the given index, without checking it.
+	 * \arg	c		index of the cell within the board, in the range [0,80]
+	 */
+	inline Cell& Board::at(short unsigned int c) {
+		return *Cells[c];
+	}
+	
+	/**
+	 * Makes a cell definitive, counting its value in its row, column and box and removing it from
+	 * the possibilities of its undecided peers.
+	 * \arg	c		index of an undecided cell within the board
+	 * \arg	value	the value to set, in the range [1,9]
+	 */
+	void Board::put(short unsigned int c, short unsigned int value) {
+		at(c).fastSet(value);
+		
+		for(short unsigned int k = 0; k < 3; k++)
+			Counts[CellUnits[c][k]][value - 1]++;
+		
+		for(short unsigned int i = 0; i < 20; i++) {
+			Cell& peer = at(Peers[c][i]);
+			
+			if(peer.State == undecided)
+				peer.fastRemove(value);
+		}
+	}
+	
+	/**
+	 * Makes a definitive cell undecided, giving back its value to the peers where it fits again.
+	 * \arg	c		index of a definitive cell within the board
+	 */
+	void Board::clear(short unsigned int c) {
+		short unsigned int value = at(c).Possibilities[0];
+		
+		for(short unsigned int k = 0; k < 3; k++)
+			Counts[CellUnits[c][k]][value - 1]--;
+		
+		at(c).State = undecided;
+		refresh(c);
+		
+		for(short unsigned int i = 0; i < 20; i++) {
+			short unsigned int p = Peers[c][i];
+			
+			if(at(p).State == undecided && !Counts[CellUnits[p][0]][value - 1] &&
+				!Counts[CellUnits[p][1]][value - 1] && !Counts[CellUnits[p][2]][value - 1])
+				at(p).fastAddPossibility(value);
+		}
+	}
+	
+	/**
+	 * Rebuilds the possibilities of an undecided cell: the values not placed in its row, column or box.
+	 * \arg	c		index of an undecided cell within the board
+	 */
+	void Board::refresh(short unsigned int c) {
+		const short unsigned int *row = Counts[CellUnits[c][0]], *col = Counts[CellUnits[c][1]],
+			*box = Counts[CellUnits[c][2]];
+		Cell& cell = at(c);
+		short unsigned int n = 0;
+		
+		for(short unsigned int p = 0; p < 9; p++)
+			if(!row[p] && !col[p] && !box[p])
+				cell.Possibilities[n++] = p + 1;
+		
+		for(; n < 9; n++)
+			cell.Possibilities[n] = 0;
+	}
+	
+	/**
+	 * Places a value in a cell, as a player move which can be undone.
+	 * The possibilities of the undecided cells are kept exact: a value is possible in a cell if and
+	 * only if it's not placed in its row, column or box. This costs one pass over the cell peers.
+	 * If the cell already had a value, it's replaced.
+	 * \arg	i		row index of the Cell within the board.
+	 * \arg	j		col index of the Cell within the board.
+	 * \arg	value	the value to place
+	 * \return	false if the value is already placed in the row, column or box of the cell, in
+	 *			which case nothing is changed
+	 * \throw	domain_error	Thrown if 'i' and/or 'j' arguments are not within the range [0,8],
+	 *							or if the value is not within the range [1,9]
+	 */
+	bool Board::place(short unsigned int i, short unsigned int j, short unsigned int value) {
+		if(!canPlace(i, j, value)) // this can throw domain_error
+			return false;
+		
+		short unsigned int c = i * 9 + j;
+		Cell& cell = at(c);
+		Move move = { static_cast<unsigned char>(c), 0, static_cast<unsigned char>(value) };
+		
+		if(cell.State == definitive) {
+			move.Before = cell.Possibilities[0];
+			if(move.Before == value)
+				return true;
+			clear(c);
+		}
+		
+		put(c, value);
+		Journal.push_back(move);
+		Version++;
+		return true;
+	}
+	
+	/**
+	 * Erases the value of a cell, as a player move which can be undone.
+	 * Nothing is done if the cell is undecided.
+	 * \arg	i		row index of the Cell within the board.
+	 * \arg	j		col index of the Cell within the board.
+	 * \throw	domain_error	Thrown if 'i' and/or 'j' arguments are not within the range [0,8]
+	 */
+	void Board::erase(short unsigned int i, short unsigned int j) {
+		if(i >= 9 || j >= 9)
+			throw domain_error("Tried to erase a non existant Cell providing invalid 'x' and 'y' indexes");
+		
+		short unsigned int c = i * 9 + j;
+		
+		if(at(c).State == definitive) {
+			Move move = { static_cast<unsigned char>(c), static_cast<unsigned char>(at(c).Possibilities[0]), 0 };
+			
+			clear(c);
+			Journal.push_back(move);
+			Version++;
+		}
+	}
+	
+	/**
+	 * Undoes the last move made with place() or erase().
+	 * \return	false if there was no move to undo
+	 */
+	bool Board::undo() {
+		if(Journal.empty())
+			return false;
+		
+		Move move = Journal.back();
+		Journal.pop_back();
+		
+		if(move.After)
+			clear(move.Index);
+		if(move.Before)
+			put(move.Index, move.Before);
+		
+		Version++;
+		return true;
+	}
+	
+	/**
+	 * States if a value can be placed in a cell, that is, if it isn't placed yet in any other cell
+	 * of its row, column or box.
+	 * \arg	i		row index of the Cell within the board.
+	 * \arg	j		col index of the Cell within the board.
+	 * \arg	value	the value to test
+	 * \throw	domain_error	Thrown if 'i' and/or 'j' arguments are not within the range [0,8],
+	 *							or if the value is not within the range [1,9]
+	 */
+	bool Board::canPlace(short unsigned int i, short unsigned int j, short unsigned int value) const {
+		if(i >= 9 || j >= 9)
+			throw domain_error("Tried to place a value in a non existant Cell providing invalid 'x' and 'y' indexes");
+		Cell::check(value); // this can throw domain_error
+		
+		short unsigned int c = i * 9 + j;
+		const Cell& cell = *Cells[c];
+		
+		if(cell.State == definitive && cell.Possibilities[0] == value)
+			return true;
+		
+		return !Counts[CellUnits[c][0]][value - 1] && !Counts[CellUnits[c][1]][value - 1] &&
+			!Counts[CellUnits[c][2]][value - 1];
+	}
+	
+	/**
+	 * Rebuilds the counts of placed values and the exact possibilities of every undecided cell
+	 * from the definitive cells. Needed before using place(), erase() or undo() if the board
+	 * cells were changed by other means; it also forgets the moves to undo.
+	 */
+	void Board::recount() {
+		for(short unsigned int u = 0; u < 27; u++)
+			for(short unsigned int p = 0; p < 9; p++)
+				Counts[u][p] = 0;
+		
+		for(short unsigned int c = 0; c < 81; c++)
+			if(at(c).State == definitive)
+				for(short unsigned int k = 0; k < 3; k++)
+					Counts[CellUnits[c][k]][at(c).Possibilities[0] - 1]++;
+		
+		for(short unsigned int c = 0; c < 81; c++)
+			if(at(c).State == undecided)
+				refresh(c);
+		
+		Journal.clear();
+		Version++;
 	}
 	
 	/**
@@ -631,7 +942,7 @@ namespace sudoku {
 	 * \return	Requested Row reference.
 	 * \throw	domain_error	Thrown if 'i' is not within the range [0,8]
 	 */
-	inline Line& Board::operator[](short unsigned int i) throw (domain_error) {
+	Line& Board::operator[](short unsigned int i) {
 		if(i < 9)
 			return Rows[i];
 		else
@@ -659,7 +970,7 @@ namespace sudoku {
 	 * \return	Requested Column reference.
 	 * \throw	domain_error	Thrown if 'i' is not within the range [0,8]
 	 */
-	inline Line& Board::getCol(short unsigned int i) throw(domain_error) {
+	Line& Board::getCol(short unsigned int i) {
 		if (i < 9)
 			return Cols[i];
 		else
@@ -672,7 +983,7 @@ namespace sudoku {
 	* \return 	A Line object reference correspoding with the requested Row
 	* \throw	domain_error	Thrown if 'i' is not within the range [0,8]
 	*/
-	inline Line& Board::getRow(short unsigned int i) throw(domain_error) {
+	Line& Board::getRow(short unsigned int i) {
 		if (i < 9)
 			return Rows[i];
 		else
@@ -686,7 +997,7 @@ namespace sudoku {
 	* \return 	A Box object reference correspoding with the requested one
 	* \throw	domain_error	Thrown if 'i' and/or 'j' arguments are not within the range [0,2]
 	*/
-	inline Box& Board::getBox(short unsigned int i,short unsigned int j) throw(domain_error) {
+	Box& Board::getBox(short unsigned int i,short unsigned int j) {
 		if (i < 3 && j < 3)
 			return Boxes[i][j];
 		else
@@ -700,7 +1011,7 @@ namespace sudoku {
 	* \return 	A Cell object reference correspoding with the requested one
 	* \throw	domain_error	Thrown if 'i' and/or 'j' arguments isare not within the range [0,8]
 	*/
-	inline Cell& Board::getCell(short unsigned int i, short unsigned int j) throw(domain_error) {
+	Cell& Board::getCell(short unsigned int i, short unsigned int j) {
 		if (i < 9 && j < 9) {
 			Cell** cell = Rows[i];
 			return *cell[j];
@@ -714,71 +1025,72 @@ namespace sudoku {
 	* \arg	i	row index of the Cell within the board.
 	* \arg	J	col index of the Cell within the board.
 	* \return 	A Cell object reference correspoding with the requested one
+	* The board is recounted: the value leaves the possibilities of its peers and the moves to
+	* undo are forgotten.
 	* \throw	domain_error	Thrown if 'i' and/or 'j' arguments isare not within the range [0,8],
 	*							or if the given value is not inside the cell posibilities list
 	*/
-	inline void Board::setCell(short unsigned int i, short unsigned int j, short unsigned int value) throw(domain_error) {
+	void Board::setCell(short unsigned int i, short unsigned int j, short unsigned int value) {
 		if (i < 9 && j < 9) {
 			Rows[i][j]->set(value); // this can throw domain_error
+			recount();
 		} else
 			throw domain_error("Tried to set to a non existant Cell providing invalid 'x' and 'y' indexes");
 	}
 	
+	/**
+	 * Removes the value of a definitive cell from the possibilities of its row, column and box.
+	 * \arg	Sudoku	board where the cell resides
+	 * \arg	c		index of the definitive cell within the board
+	 * \throw 	logic_error		Thrown if no possibility is left in any of the cells
+	 */
+	void Solver::propagate(Board& Sudoku, short unsigned int c) {
+		short unsigned int p = Sudoku.at(c).get();
+		
+		for(short unsigned int i = 0; i < 20; i++)
+			Sudoku.at(Peers[c][i]).fastDelPossibility(p); // this can throw logic_error
+	}
+	
 	/**
 	 * Update cells posibilities
 	 * \throw 	logic_error		Thrown if no possibility is left in any of the cells or
 	 */
-	void Solver::updatePossibilities(Board& Sudoku) throw(logic_error) {
-		for(short unsigned int i = 0, I = 0; I < 9; I++, (I % 3 == 0) ? i++ : i) {
-			for(short unsigned int j = 0, J = 0; J < 9; J++, (J % 3 == 0) ? j++ : j) {
-				Cell& cell = *(Sudoku.Rows[I][J]);
-				
-				if(cell.getState() == definitive)
-				{
-					short unsigned int p = cell.get();
-					Sudoku.Boxes[i][j].delPossibility(p, cell); // this can throw logic_error
- 					Sudoku.Rows[I].delPossibility(p, cell); // this can throw logic_error
- 					Sudoku.Cols[J].delPossibility(p, cell); // this can throw logic_error
-				}
-			}
-		}
+	void Solver::updatePossibilities(Board& Sudoku) {
+		for(short unsigned int c = 0; c < 81; c++)
+			if(Sudoku.at(c).getState() == definitive)
+				propagate(Sudoku, c); // this can throw logic_error
 	}
 	
 	/**
 	 * Resolve and set the final state of cell if possible, or at least eliminate some possibilities.
 	 * After performing the solving operation, this function automatically updates the row, column
 	 * and box where it resides.
-	 * \arg	cell	reference to the cell to solve
-	 * \arg	row		reference to the row in which the cell resides
-	 * \arg	col		reference to the column in which the cell resides
-	 * \arg	box		reference to the box in which the cell resides
+	 * \arg	Sudoku	board where the cell resides
+	 * \arg	c		index of the cell to solve within the board
 	 * \return 		true if the any of success happened, or false otherwise
 	 * \throw 	logic_error		Thrown if no possibility is left in any of the cells tested
 	 * \throw 	domain_error	Thrown if cell is already set and it's attempted to set it
 	 *							to a different value
 	 */
-	bool Solver::solveCell(Cell& cell, Line& row, Line& col, Box& box) throw(domain_error, logic_error) {
-		
+	bool Solver::solveCell(Board& Sudoku, short unsigned int c) {
+		Cell& cell = Sudoku.at(c);
 		short unsigned int* Possibilities = cell.getPossibilities();
 		
-		for(int i = 0; Possibilities[i] != 0 && i < 9; i++) {
+		for(int i = 0; i < 9 && Possibilities[i] != 0; i++) {
 			short unsigned int pos = Possibilities[i];
 			
-			if(!row.isPossible(pos, cell)) {
-				cell.set(pos); // this can throw domain_error
-				col.delPossibility(pos, cell); // this can throw logic_error
-				box.delPossibility(pos, cell); // this can throw logic_error
-				return true;
-			} else if(!col.isPossible(pos, cell)) {
-				cell.set(pos); // this can throw domain_error
-				row.delPossibility(pos, cell); // this can throw logic_error
-				box.delPossibility(pos, cell); // this can throw logic_error
-				return true;
-			} else if(!box.isPossible(pos, cell)) {
-				cell.set(pos); // this can throw domain_error
-				col.delPossibility(pos, cell); // this can throw logic_error
-				row.delPossibility(pos, cell); // this can throw logic_error
-				return true;
+			// The value is solved if no other cell of the row, the column or the box can hold it
+			for(short unsigned int kind = 0; kind < 3; kind++) {
+				short unsigned int j = 0;
+				
+				while(j < 8 && !Sudoku.at(UnitPeers[c][kind][j]).fastIsPossible(pos))
+					j++;
+				
+				if(j == 8) {
+					cell.set(pos); // this can throw domain_error
+					propagate(Sudoku, c); // this can throw logic_error
+					return true;
+				}
 			}
 		}
 		
@@ -787,63 +1099,74 @@ namespace sudoku {
 	
 	/**
 	 * Resolves a Sudoku game.
-	 * \return true if it resolved the game, false otherwise.
+	 * Cells left with a single possibility become definitive on their own, so every pass also
+	 * removes the value of the new definitive cells from their row, column and box.
 	 */
 	void Solver::resolve(Board& Sudoku) {
-		bool loop = true, temp;
+		Budget unlimited;
 		
-		updatePossibilities(Sudoku);
+		resolve(Sudoku, unlimited);
+	}
+	
+	/**
+	 * Resolves a Sudoku game within a budget, spending a node per pass over the board.
+	 * The board is recounted at the end, as after setCell(), even if an exception is thrown.
+	 * \arg	Sudoku	board to resolve
+	 * \arg	budget	limits of the resolution
+	 * \return	false if the budget was exceeded before the passes stopped making progress
+	 */
+	bool Solver::resolve(Board& Sudoku, Budget& budget) {
+		SUDOKU_TRACE_SPAN("resolve");
+		bool loop = true, propagated[81];
 		
-		while(loop) {
-			loop = false;
+		try {
+			updatePossibilities(Sudoku);
 			
-			for(short unsigned int i = 0, I=0; I < 9; I++, (I % 3 == 0) ? i++ : i) {
-				for(short unsigned int j = 0, J = 0; J < 9; J++, (J % 3 == 0) ? j++ : j) {
-					if (Sudoku.Rows[I][J]->getState() == undecided) {
-						temp = solveCell(*Sudoku.Rows[I][J], Sudoku.Rows[I], Sudoku.Cols[J], Sudoku.Boxes[i][j]);
-						
-						if(temp && !loop)
+			for(short unsigned int c = 0; c < 81; c++)
+				propagated[c] = Sudoku.at(c).getState() == definitive;
+			
+			while(loop) {
+				SUDOKU_TRACE_SPAN("propagation pass");
+				
+				if(!budget.spend())
+					break;
+				
+				loop = false;
+				
+				for(short unsigned int c = 0; c < 81; c++) {
+					if(Sudoku.at(c).getState() == undecided) {
+						if(solveCell(Sudoku, c))
 							loop = true;
+					} else if(!propagated[c]) {
+						propagate(Sudoku, c);
+						propagated[c] = true;
+						loop = true;
 					}
 				}
 			}
+		} catch (...) {
+			// the cells were set behind the counts of the board, which place() and the hints rely on
+			Sudoku.recount();
+			throw;
 		}
+		
+		Sudoku.recount();
+		return !loop;
 	}
 	
 	/**
 	 * Prints the sudoku board in the command line
-	 * Shows the first possiblity for each cell (even if its final value is still undecided).
+	 * The terminal is cleared with ANSI escapes and the whole board is written at once.
 	 */
 	void Display::show(Board& Sudoku) {
+		static const char clear[] = "\033[H\033[2J";
+		char buffer[sizeof(clear) - 1 + 1024];
 		
-		system("clear");
-		string lineSeparator1("---||---|---|---||---|---|---||---|---|---||\n"),
-			lineSeparator2("===||###|###|###||###|###|###||###|###|###||\n");
+		memcpy(buffer, clear, sizeof(clear) - 1);
+		size_t length = Render::format(Sudoku, pretty, buffer + sizeof(clear) - 1, sizeof(buffer) - sizeof(clear) + 1);
 		
-		cout << "y\\x|| 1 | 2 | 3 || 4 | 5 | 6 || 7 | 8 | 9 ||\n";
-		cout << lineSeparator2;
-		
-		for(int i = 0; i < 9; i++) {
-			cout << " " << i+1 << " || ";
-			for(int j = 0; j < 9; j++) {
-				Cell& cell = *Sudoku[i][j];
-				
-				if(cell.State == definitive)
-					cout << cell.Possibilities[0];
-				else
-					cout << " ";
-				
-				if((j + 1) % 3 == 0)
-					cout << " || ";
-				else
-					cout << " | ";
-				
-			}
-			if((i + 1) % 3 == 0)
-				cout << endl << lineSeparator2;
-			else
-				cout << endl << lineSeparator1;
-		}
+		cout.flush();
+		Render::emit(1, buffer, sizeof(clear) - 1 + length);
 	}
 	
 	/**
@@ -868,24 +1191,28 @@ namespace sudoku {
 	 * Set the cell to given state if possible.
 	 * After performing the solving operation, this function automatically updates the row, column
 	 * and box where it resides.
-	 * \arg	cell	reference to the cell to solve
-	 * \arg	row		reference to the row in which the cell resides
-	 * \arg	col		reference to the column in which the cell resides
-	 * \arg	box		reference to the box in which the cell resides
+	 * \arg	Sudoku	board where the cell resides
+	 * \arg	c		index of the cell to solve within the board
 	 * \arg sol		Value to set the cell if possible
 	 * \return 		true if the any of success happened, or false otherwise
 	 * \throw 	logic_error		Thrown if no possibility is left in any of the cells tested
 	 */
-	bool Generator::solveCell(Cell& cell, Line& row, Line& col, Box& box, short unsigned int sol) throw(domain_error, logic_error) {
-		if(cell.isPossible(sol) && row.canDel(sol, cell) && col.canDel(sol, cell) && box.canDel(sol, cell)) {
-			cell.set(sol); // this can theoretically throw domain_error but shouldn't
-			row.delPossibility(sol, cell); // this can throw logic_error
-			col.delPossibility(sol, cell); // this can throw logic_error
-			box.delPossibility(sol, cell); // this can throw logic_error
-			return true;
-		}
+	bool Generator::solveCell(Board& Sudoku, short unsigned int c, short unsigned int sol) {
+		Cell& cell = Sudoku.at(c);
 		
-		return false;
+		if(!cell.isPossible(sol))
+			return false;
+		
+		for(short unsigned int i = 0; i < 20; i++)
+			if(!Sudoku.at(Peers[c][i]).fastCanDel(sol))
+				return false;
+		
+		cell.set(sol); // this can theoretically throw domain_error but shouldn't
+		
+		for(short unsigned int i = 0; i < 20; i++)
+			Sudoku.at(Peers[c][i]).fastDelPossibility(sol); // this can throw logic_error
+		
+		return true;
 	}
 }
 }
@@ -11,11 +11,14 @@
 #include <cstdlib>
 #include <ctime>
 #include <cstdio>
+#include <vector>
+#include <utility>
 
 
 namespace std {
 namespace sudoku {
 	class Display;
+	class Budget;
 	
 	typedef enum{undecided,definitive} state;
 	typedef enum{cols,rows,boxes} tGet;
@@ -30,12 +33,18 @@ namespace sudoku {
 		friend class Solver;
 		friend class Generator;
 		friend class Display;
+		friend class Grid;
+		friend class Render;
+		friend class Board;
+		friend class Hinter;
+		friend class Reducer;
 		
-		static void check(short unsigned int myP) throw(domain_error);
-		void fastDelPossibility(short unsigned int myP) throw(logic_error);
+		static void check(short unsigned int myP);
+		void fastDelPossibility(short unsigned int myP);
 		bool fastCanDel(short unsigned int myP) const;
 		void fastAddPossibility(short unsigned int myP);
 		bool fastIsPossible(short unsigned int myP) const;
+		void fastRemove(short unsigned int myP);
 		void fastSet(short unsigned int myP);
 		
 	public:
@@ -44,13 +53,19 @@ namespace sudoku {
 		void copy(const Cell& copy);
 		~Cell();
 		
-		short unsigned int* getPossibilities();
-		void addPossibility(short unsigned int myP) throw(domain_error);
-		void delPossibility(short unsigned int myP) throw(logic_error);
-		void set(short unsigned int myP) throw(domain_error);
-		short unsigned int get() throw(logic_error);
+		/**
+		 * Returns the available possibilities to the user, ended by a 0 if there are less than 9.
+		 */
+		short unsigned int* getPossibilities() noexcept { return Possibilities; }
+		void addPossibility(short unsigned int myP);
+		void delPossibility(short unsigned int myP);
+		void set(short unsigned int myP);
+		short unsigned int get();
 		bool isPossible(short unsigned int myP) const;
-		state getState() const;
+		/**
+		 * Returns current Cell state, either undecided or definitive.
+		 */
+		state getState() const noexcept { return State; }
 		void setState(state S);
 		void erase();
 	};
@@ -59,9 +74,9 @@ namespace sudoku {
 		Cell *elements[3][3];
 		
 	public:
-		Cell** operator[] (short unsigned int i) throw(domain_error);
+		Cell** operator[] (short unsigned int i);
 		
-		void delPossibility(short unsigned int myP, Cell& cell) throw(logic_error);
+		void delPossibility(short unsigned int myP, Cell& cell);
 		void addPossibility(short unsigned int myP);
 		bool isPossible(short unsigned int myP, Cell& cell) const;
 		bool canDel(short unsigned int myP, Cell& cell) const;
@@ -73,44 +88,94 @@ namespace sudoku {
 	public:
 		operator Cell**();
 		
-		void delPossibility(short unsigned int myP, Cell& cell) throw(logic_error);
+		void delPossibility(short unsigned int myP, Cell& cell);
 		void addPossibility(short unsigned int myP);
 		bool isPossible(short unsigned int myP, Cell& cell) const;
 		bool canDel(short unsigned int myP, Cell& cell) const;
-		void deleteAll();
-		Cell copy(short unsigned int i) const throw(domain_error);
+		Cell copy(short unsigned int i) const;
 	};
 	
+	/**
+	 * A move of the incremental play API: the value of a cell before and after it
+	 */
+	typedef struct {
+		unsigned char Index, Before, After;
+	} Move;
+	
+	/**
+	 * A sudoku board. Its 81 cells live in a single block, which its rows, columns and boxes
+	 * point to, so a board is copied with one allocation and moved by taking the block of the
+	 * other one, without any; a board moved from can only be assigned or destroyed.
+	 * The accessors taking indexes check them and throw domain_error, for user input; their fast
+	 * versions don't, for the engines which already know them to be valid.
+	 */
 	class Board {
+		Cell* Storage;
+		Cell *Cells[81];
 		Line Cols[9], Rows[9];
 		Box Boxes[3][3];
+		short unsigned int Counts[27][9];
+		vector<Move> Journal;
+		unsigned long Identity;	// unique to each board built, copied or assigned
+		unsigned long Version;	// counts the moves and recounts since then
+		
+		void link(short unsigned int c, Cell* cell);
+		Cell& at(short unsigned int c);
+		void put(short unsigned int c, short unsigned int value);
+		void clear(short unsigned int c);
+		void refresh(short unsigned int c);
+		bool fill(Board* solution, short unsigned int solvedCells, Budget& budget);
 		
 		friend class Solver;
 		friend class Generator;
+		friend class Grid;
+		friend class Render;
+		friend class Hinter;
+		friend class Reducer;
 		
 	public:
 		Board();
 		Board(Board* solution, short unsigned int solvedCells = 30);
 		Board(const Board& copy);
+		Board(Board&& other) noexcept;
 		~Board();
 		
-		Line& operator[](short unsigned int i) throw (domain_error);
+		Board& operator=(const Board& copy);
+		Board& operator=(Board&& other) noexcept;
+		void swap(Board& other) noexcept;
+		
+		Line& operator[](short unsigned int i);
 		
 		state getState();
-		Line& getCol(short unsigned int i) throw(domain_error);
-		Line& getRow(short unsigned int i) throw(domain_error);
-		Box& getBox(short unsigned int i, short unsigned int j) throw(domain_error);
-		Cell& getCell(short unsigned int i, short unsigned int j) throw(domain_error);
-		void setCell(short unsigned int i, short unsigned int j, short unsigned int value) throw(domain_error);
+		Line& getCol(short unsigned int i);
+		Line& getRow(short unsigned int i);
+		Box& getBox(short unsigned int i, short unsigned int j);
+		Cell& getCell(short unsigned int i, short unsigned int j);
+		void setCell(short unsigned int i, short unsigned int j, short unsigned int value);
+		
+		Line& fastGetCol(short unsigned int i) noexcept { return Cols[i]; }
+		Line& fastGetRow(short unsigned int i) noexcept { return Rows[i]; }
+		Box& fastGetBox(short unsigned int i, short unsigned int j) noexcept { return Boxes[i][j]; }
+		Cell& fastGetCell(short unsigned int i, short unsigned int j) noexcept { return *Cells[i * 9 + j]; }
+		const Cell& fastGetCell(short unsigned int i, short unsigned int j) const noexcept { return *Cells[i * 9 + j]; }
+		
+		bool place(short unsigned int i, short unsigned int j, short unsigned int value);
+		void erase(short unsigned int i, short unsigned int j);
+		bool undo();
+		bool canPlace(short unsigned int i, short unsigned int j, short unsigned int value) const;
+		void recount();
+		bool generate(Board* solution, short unsigned int solvedCells, Budget& budget);
 	};
 	
 	class Solver {
 	 	Solver();
 		
-		static void updatePossibilities(Board& Sudoku) throw(logic_error);
-		static bool solveCell(Cell& cell, Line& row, Line& col, Box& box) throw(domain_error, logic_error);
+		static void propagate(Board& Sudoku, short unsigned int c);
+		static void updatePossibilities(Board& Sudoku);
+		static bool solveCell(Board& Sudoku, short unsigned int c);
 	public:
 		static void resolve(Board& Sudoku);
+		static bool resolve(Board& Sudoku, Budget& budget);
 	};
 	
 	class Display {
@@ -122,7 +187,7 @@ namespace sudoku {
 	class Generator {
 	 	Generator();
 	public:
-		static bool solveCell(Cell& cell, Line& row, Line& col, Box& box, short unsigned int sol) throw(domain_error, logic_error);
+		static bool solveCell(Board& Sudoku, short unsigned int c, short unsigned int sol);
 		static short unsigned int nextValue(short unsigned int mod = 10, unsigned short int min = 1);
 		
 	};
@@ -0,0 +1,161 @@
+// See COPYING file for licensing information.
+/**
+ * \file symmetry.cpp
+ * Implementation of the transformations turning a puzzle into equivalent ones.
+ * A transformation is built once from small permutation tables into a cell map and a character
+ * translation table, so applying it is just one table lookup per cell.
+ */
+#include "symmetry.h"
+
+namespace std {
+namespace sudoku {
+	/** The 6 permutations of 3 elements */
+	const unsigned char Symmetry::Permutations[6][3] = {
+		{ 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }
+	};
+
+	/**
+	 * Returns a pseudo random number in [0,Transforms).
+	 */
+	unsigned long long Symmetry::random() {
+		unsigned long long value = 0;
+
+		for(short unsigned int i = 0; i < 3; i++)
+			value = value * 65535 + Generator::nextValue(65535, 0);
+
+		return value % Transforms;
+	}
+
+	/**
+	 * Returns the greatest common divisor of two numbers.
+	 */
+	static unsigned long long divisor(unsigned long long a, unsigned long long b) {
+		while(b != 0) {
+			unsigned long long r = a % b;
+
+			a = b;
+			b = r;
+		}
+
+		return a;
+	}
+
+	/**
+	 * Symmetry constructor. Picks a random start and a random stride.
+	 */
+	Symmetry::Symmetry() {
+		Next = random();
+		Stride = random() % (Transforms - 1) + 1;
+
+		// The stride must be coprime with Transforms for the first Transforms steps to be distinct
+		while(divisor(Transforms, Stride) != 1)
+			Stride = Stride % (Transforms - 1) + 1;
+	}
+
+	/**
+	 * Builds a transformation from its number.
+	 * \arg		index		number of the transformation, in [0,Transforms); 0 is the identity
+	 * \arg		transform	where the transformation is built
+	 */
+	void Symmetry::build(unsigned long long index, Transform& transform) {
+		bool transpose = index % 2;
+		short unsigned int rows[9], cols[9], band, stack;
+		unsigned char digits[9] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+		index /= 2;
+		band = index % 6;
+		index /= 6;
+		stack = index % 6;
+		index /= 6;
+
+		for(short unsigned int b = 0; b < 3; b++) {
+			short unsigned int order = index % 6;
+
+			index /= 6;
+			for(short unsigned int i = 0; i < 3; i++)
+				rows[b * 3 + i] = Permutations[band][b] * 3 + Permutations[order][i];
+		}
+		for(short unsigned int s = 0; s < 3; s++) {
+			short unsigned int order = index % 6;
+
+			index /= 6;
+			for(short unsigned int i = 0; i < 3; i++)
+				cols[s * 3 + i] = Permutations[stack][s] * 3 + Permutations[order][i];
+		}
+
+		for(short unsigned int c = 0; c < 81; c++)
+			transform.Cells[c] = transpose ? cols[c % 9] * 9 + rows[c / 9] : rows[c / 9] * 9 + cols[c % 9];
+
+		for(short unsigned int i = 0; i < 256; i++)
+			transform.Digits[i] = static_cast<char>(i);
+
+		// What's left of the index is the rank of the digits permutation among the 9! ones
+		unsigned long factorial = 40320;
+
+		for(short unsigned int i = 0; i < 9; i++) {
+			short unsigned int k = index / factorial;
+			unsigned char digit = digits[i + k];
+
+			index %= factorial;
+			if(i < 8)
+				factorial /= 8 - i;
+
+			for(short unsigned int j = i + k; j > i; j--)
+				digits[j] = digits[j - 1];
+			digits[i] = digit;
+			transform.Digits['1' + i] = digit;
+		}
+	}
+
+	/**
+	 * Applies a transformation to a puzzle.
+	 * \arg		transform	the transformation
+	 * \arg		in			the 81 cells of the puzzle, row by row, as characters
+	 * \arg		out			where the 81 cells of the transformed puzzle are written
+	 */
+	void Symmetry::apply(const Transform& transform, const char* in, char* out) {
+		for(short unsigned int c = 0; c < 81; c++)
+			out[c] = transform.Digits[static_cast<unsigned char>(in[transform.Cells[c]])];
+	}
+
+	/**
+	 * Builds the next transformation of the sequence.
+	 * \arg		transform	where the transformation is built
+	 */
+	void Symmetry::next(Transform& transform) {
+		if(Next == 0)
+			Next = (Next + Stride) % Transforms;
+
+		build(Next, transform);
+		Next = (Next + Stride) % Transforms;
+	}
+
+	/**
+	 * Writes transformed copies of a set of puzzles. Each round builds a new transformation and
+	 * applies it to every seed, so the cost of building it is shared by the whole set.
+	 * \arg		seeds	the puzzles, as lines of 81 characters and a new line, as Render writes
+	 *					them in the oneline format
+	 * \arg		count	number of puzzles in seeds
+	 * \arg		copies	number of copies to write of each puzzle
+	 * \arg		out		where the copies are written in the same format, round by round
+	 * \arg		length	size of out; only whole rounds are written
+	 * \return	number of bytes written
+	 */
+	size_t Symmetry::multiply(const char* seeds, size_t count, size_t copies, char* out, size_t length) {
+		Transform transform;
+		char* end = out;
+
+		for(size_t r = 0; r < copies && length - (end - out) >= count * 82; r++) {
+			next(transform);
+
+			for(size_t s = 0; s < count; s++) {
+				apply(transform, seeds + s * 82, end);
+				end[81] = '\n';
+				end += 82;
+			}
+		}
+
+		return end - out;
+	}
+}
+}
@@ -0,0 +1,51 @@
+// See COPYING file for licensing information.
+/**
+ * \file symmetry.h
+ * Definition of the transformations turning a puzzle into equivalent ones.
+ */
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include "sudoku.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * A transformation keeping the solutions of a puzzle, their number and its difficulty: a
+	 * relabeling of the digits, a permutation of the bands, of the stacks, of the rows within each
+	 * band and of the columns within each stack, and an optional transposition. Cells[c] is the
+	 * cell of the original puzzle moved to c, and Digits translates every character of the original
+	 * puzzle, leaving unchanged the ones which aren't digits in [1,9].
+	 */
+	typedef struct {
+		unsigned char Cells[81];
+		char Digits[256];
+	} Transform;
+
+	/**
+	 * Multiplier of puzzles through transformations.
+	 * The 2 * 6^8 * 9! transformations are numbered, and a Symmetry goes through them with a random
+	 * start and a random stride coprime with their number, so that it never gives the same one
+	 * twice until all of them have been given. The identity is skipped.
+	 */
+	class Symmetry {
+		unsigned long long Stride;
+		unsigned long long Next;
+
+		static const unsigned char Permutations[6][3];
+		static unsigned long long random();
+	public:
+		static const unsigned long long Transforms = 2ULL * 1679616ULL * 362880ULL;
+
+		Symmetry();
+
+		static void build(unsigned long long index, Transform& transform);
+		static void apply(const Transform& transform, const char* in, char* out);
+
+		void next(Transform& transform);
+		size_t multiply(const char* seeds, size_t count, size_t copies, char* out, size_t length);
+	};
+}
+}
+#endif
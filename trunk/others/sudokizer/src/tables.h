@@ -0,0 +1,104 @@
+// See COPYING file for licensing information.
+/**
+ * \file tables.h
+ * Geometry of the sudoku board, as constant tables generated at compile time.
+ *
+ * Cells are numbered from 0 to 80 row by row. Units are numbered from 0 to 26: rows first (0 to 8),
+ * then columns (9 to 17) and then boxes (18 to 26), boxes also numbered row by row. Every entry is
+ * a constant expression of its indexes, so the compiler sees the tables' contents and can fully
+ * unroll the loops running over them.
+ */
+
+#ifndef TABLES_H
+#define TABLES_H
+
+// Row, column and box of a cell, and position of the cell within its box
+#define SUDOKU_ROW(c)		((c) / 9)
+#define SUDOKU_COL(c)		((c) % 9)
+#define SUDOKU_BOX(c)		(((c) / 27) * 3 + ((c) % 9) / 3)
+#define SUDOKU_INBOX(c)		((SUDOKU_ROW(c) % 3) * 3 + SUDOKU_COL(c) % 3)
+
+// k-th index in [0,8] skipping the given one, for k in [0,7]
+#define SUDOKU_SKIP(k, own)	((k) < (own) ? (k) : (k) + 1)
+
+// i-th cell of a row, column or box
+#define SUDOKU_ROW_CELL(r, i)	((r) * 9 + (i))
+#define SUDOKU_COL_CELL(c, i)	((i) * 9 + (c))
+#define SUDOKU_BOX_CELL(b, i)	((((b) / 3) * 3 + (i) / 3) * 9 + ((b) % 3) * 3 + (i) % 3)
+#define SUDOKU_UNIT_CELL(u, i)	((u) < 9 ? SUDOKU_ROW_CELL(u, i) : (u) < 18 ? SUDOKU_COL_CELL((u) - 9, i) : \
+	SUDOKU_BOX_CELL((u) - 18, i))
+
+// k-th other cell, for k in [0,7], of the row, column and box of a cell
+#define SUDOKU_ROW_PEER(c, k)	SUDOKU_ROW_CELL(SUDOKU_ROW(c), SUDOKU_SKIP(k, SUDOKU_COL(c)))
+#define SUDOKU_COL_PEER(c, k)	SUDOKU_COL_CELL(SUDOKU_COL(c), SUDOKU_SKIP(k, SUDOKU_ROW(c)))
+#define SUDOKU_BOX_PEER(c, k)	SUDOKU_BOX_CELL(SUDOKU_BOX(c), SUDOKU_SKIP(k, SUDOKU_INBOX(c)))
+
+// k-th cell, for k in [0,3], of the box of a cell which is neither in its row nor in its column
+#define SUDOKU_CORNER_PEER(c, k)	((SUDOKU_ROW(c) / 3 * 3 + (SUDOKU_ROW(c) % 3 + 1 + (k) / 2) % 3) * 9 + \
+	SUDOKU_COL(c) / 3 * 3 + (SUDOKU_COL(c) % 3 + 1 + (k) % 2) % 3)
+
+// i-th cell, for i in [0,2], shared by box b and the k-th line crossing it: k in [0,2] for its rows
+// and k in [3,5] for its columns
+#define SUDOKU_CROSS_CELL(b, k, i)	((k) < 3 ? SUDOKU_BOX_CELL(b, (k) * 3 + (i)) : SUDOKU_BOX_CELL(b, (i) * 3 + (k) - 3))
+#define SUDOKU_CROSS_LINE(b, k)		((k) < 3 ? ((b) / 3) * 3 + (k) : 9 + ((b) % 3) * 3 + (k) - 3)
+
+// Repetition helpers used to write the tables initializers
+#define SUDOKU_EACH3(m, a)	m(a, 0), m(a, 1), m(a, 2)
+#define SUDOKU_EACH4(m, a)	m(a, 0), m(a, 1), m(a, 2), m(a, 3)
+#define SUDOKU_EACH6(m, a)	SUDOKU_EACH3(m, a), m(a, 3), m(a, 4), m(a, 5)
+#define SUDOKU_EACH8(m, a)	SUDOKU_EACH4(m, a), m(a, 4), m(a, 5), m(a, 6), m(a, 7)
+#define SUDOKU_EACH9(m, a)	SUDOKU_EACH8(m, a), m(a, 8)
+#define SUDOKU_EACH27(m)	m(0), m(1), m(2), m(3), m(4), m(5), m(6), m(7), m(8), \
+	m(9), m(10), m(11), m(12), m(13), m(14), m(15), m(16), m(17), \
+	m(18), m(19), m(20), m(21), m(22), m(23), m(24), m(25), m(26)
+#define SUDOKU_EACH81(m)	SUDOKU_EACH27(m), \
+	m(27), m(28), m(29), m(30), m(31), m(32), m(33), m(34), m(35), \
+	m(36), m(37), m(38), m(39), m(40), m(41), m(42), m(43), m(44), \
+	m(45), m(46), m(47), m(48), m(49), m(50), m(51), m(52), m(53), \
+	m(54), m(55), m(56), m(57), m(58), m(59), m(60), m(61), m(62), \
+	m(63), m(64), m(65), m(66), m(67), m(68), m(69), m(70), m(71), \
+	m(72), m(73), m(74), m(75), m(76), m(77), m(78), m(79), m(80)
+
+#define SUDOKU_PEERS_OF(c)		{ SUDOKU_EACH8(SUDOKU_ROW_PEER, c), SUDOKU_EACH8(SUDOKU_COL_PEER, c), \
+	SUDOKU_EACH4(SUDOKU_CORNER_PEER, c) }
+#define SUDOKU_UNIT_PEERS_OF(c)	{ { SUDOKU_EACH8(SUDOKU_ROW_PEER, c) }, { SUDOKU_EACH8(SUDOKU_COL_PEER, c) }, \
+	{ SUDOKU_EACH8(SUDOKU_BOX_PEER, c) } }
+#define SUDOKU_UNITS_OF(c)		{ SUDOKU_ROW(c), 9 + SUDOKU_COL(c), 18 + SUDOKU_BOX(c) }
+#define SUDOKU_INDEXES_OF(c)	{ SUDOKU_COL(c), SUDOKU_ROW(c), SUDOKU_INBOX(c) }
+#define SUDOKU_CELLS_OF(u)		{ SUDOKU_EACH9(SUDOKU_UNIT_CELL, u) }
+#define SUDOKU_CROSS_CELLS(b, k)	{ SUDOKU_CROSS_CELL(b, k, 0), SUDOKU_CROSS_CELL(b, k, 1), SUDOKU_CROSS_CELL(b, k, 2) }
+#define SUDOKU_CROSSES_OF(b)	SUDOKU_EACH6(SUDOKU_CROSS_CELLS, b)
+#define SUDOKU_CROSS_LINES_OF(b)	SUDOKU_EACH6(SUDOKU_CROSS_LINE, b)
+
+namespace std {
+namespace sudoku {
+	/** The 20 peers of each cell: 8 in its row, 8 in its column and the 4 remaining ones of its box */
+	const unsigned char Peers[81][20] = { SUDOKU_EACH81(SUDOKU_PEERS_OF) };
+
+	/** The 8 other cells of the row, column and box of each cell */
+	const unsigned char UnitPeers[81][3][8] = { SUDOKU_EACH81(SUDOKU_UNIT_PEERS_OF) };
+
+	/** The row, column and box units of each cell */
+	const unsigned char CellUnits[81][3] = { SUDOKU_EACH81(SUDOKU_UNITS_OF) };
+
+	/** The position of each cell within its row, column and box units */
+	const unsigned char UnitIndexes[81][3] = { SUDOKU_EACH81(SUDOKU_INDEXES_OF) };
+
+	/** The 9 cells of each unit */
+	const unsigned char UnitCells[27][9] = { SUDOKU_EACH27(SUDOKU_CELLS_OF) };
+
+	/**
+	 * The 3 cells shared by each box and each of the 6 lines crossing it, indexed by box * 6 + k,
+	 * with k in [0,2] for the rows of the box and in [3,5] for its columns
+	 */
+	const unsigned char Intersections[54][3] = { SUDOKU_CROSSES_OF(0), SUDOKU_CROSSES_OF(1),
+		SUDOKU_CROSSES_OF(2), SUDOKU_CROSSES_OF(3), SUDOKU_CROSSES_OF(4), SUDOKU_CROSSES_OF(5),
+		SUDOKU_CROSSES_OF(6), SUDOKU_CROSSES_OF(7), SUDOKU_CROSSES_OF(8) };
+
+	/** The line unit of each of the box-line intersections */
+	const unsigned char IntersectionLines[54] = { SUDOKU_CROSS_LINES_OF(0), SUDOKU_CROSS_LINES_OF(1),
+		SUDOKU_CROSS_LINES_OF(2), SUDOKU_CROSS_LINES_OF(3), SUDOKU_CROSS_LINES_OF(4), SUDOKU_CROSS_LINES_OF(5),
+		SUDOKU_CROSS_LINES_OF(6), SUDOKU_CROSS_LINES_OF(7), SUDOKU_CROSS_LINES_OF(8) };
+}
+}
+#endif
@@ -0,0 +1,209 @@
+// See COPYING file for licensing information.
+/**
+ * \file trace.cpp
+ * Implementation of the optional timeline of the solver phases.
+ */
+#include "trace.h"
+#include "render.h"
+#include <cstdio>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace std {
+namespace sudoku {
+	/** Buffers of every thread which recorded something, newest first */
+	static TraceBuffer* Buffers = 0;
+	static short unsigned int Threads = 0;
+	static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+
+	/** Buffer of the calling thread */
+	static __thread TraceBuffer* Local = 0;
+
+	/** Key whose destructor gives back the buffer of an exiting thread */
+	static pthread_key_t Owner;
+	static pthread_once_t Once = PTHREAD_ONCE_INIT;
+
+	/**
+	 * Gives back the buffer of an exiting thread, which keeps its events.
+	 * \arg		buffer	the TraceBuffer
+	 */
+	static void release(void* buffer) {
+		pthread_mutex_lock(&Lock);
+		static_cast<TraceBuffer*>(buffer)->Free = true;
+		pthread_mutex_unlock(&Lock);
+	}
+
+	/**
+	 * Creates the key of the buffers, once.
+	 */
+	static void createOwner() {
+		pthread_key_create(&Owner, release);
+	}
+
+	/**
+	 * Returns the buffer of the calling thread, taking one left by an exited thread or creating
+	 * it the first time.
+	 */
+	TraceBuffer* Trace::buffer() {
+		if(Local == 0) {
+			pthread_once(&Once, createOwner);
+
+			pthread_mutex_lock(&Lock);
+			Local = Buffers;
+			while(Local != 0 && !Local->Free)
+				Local = Local->Next;
+			if(Local == 0) {
+				Local = new TraceBuffer();
+				Local->Written = 0;
+				Local->Thread = ++Threads;
+				Local->Next = Buffers;
+				Buffers = Local;
+			}
+			Local->Free = false;
+			pthread_mutex_unlock(&Lock);
+
+			pthread_setspecific(Owner, Local);
+		}
+
+		return Local;
+	}
+
+	/**
+	 * States if the timeline is recorded, that is, if SUDOKU_TRACE was defined when compiling.
+	 */
+	bool Trace::enabled() {
+#ifdef SUDOKU_TRACE
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * Returns a monotonic timestamp in nanoseconds.
+	 */
+	unsigned long long Trace::now() {
+		timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+
+	/**
+	 * Records an event in the buffer of the calling thread.
+	 * \arg		name		name of the event; it must be a string literal
+	 * \arg		phase		'X' for a span or 'i' for an instant
+	 * \arg		start		timestamp of the event, as given by now()
+	 * \arg		duration	duration of a span in nanoseconds
+	 * \arg		value		value of an instant
+	 */
+	void Trace::record(const char* name, char phase, unsigned long long start, unsigned long long duration, long value) {
+		TraceBuffer* own = buffer();
+		TraceEvent& event = own->Events[own->Written % TraceBuffer::Capacity];
+
+		event.Name = name;
+		event.Phase = phase;
+		event.Start = start;
+		event.Duration = duration;
+		event.Value = value;
+		own->Written++;
+	}
+
+	/**
+	 * Records an instant event.
+	 * \arg		name	name of the event; it must be a string literal
+	 * \arg		value	value shown with the event
+	 */
+	void Trace::instant(const char* name, long value) {
+		record(name, 'i', now(), 0, value);
+	}
+
+	/**
+	 * Writes the events of every thread as a Chrome trace JSON document. It must not be called
+	 * while other threads are recording.
+	 * \arg		fd		file descriptor where the document is written
+	 * \return	false if it couldn't be written
+	 */
+	bool Trace::dump(int fd) {
+		char buffer[4096];
+		size_t length = 0;
+		bool first = true, ok = true;
+
+		length += snprintf(buffer, sizeof(buffer), "{\"traceEvents\":[");
+
+		pthread_mutex_lock(&Lock);
+		for(TraceBuffer* own = Buffers; own != 0 && ok; own = own->Next) {
+			unsigned long long from = own->Written > TraceBuffer::Capacity ? own->Written - TraceBuffer::Capacity : 0;
+
+			for(unsigned long long i = from; i < own->Written && ok; i++) {
+				const TraceEvent& event = own->Events[i % TraceBuffer::Capacity];
+
+				// Flush before the buffer could overflow with the next event
+				if(sizeof(buffer) - length < 512) {
+					ok = Render::emit(fd, buffer, length);
+					length = 0;
+				}
+
+				if(event.Phase == 'X')
+					length += snprintf(buffer + length, sizeof(buffer) - length,
+						"%s\n{\"name\":\"%.200s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+						first ? "" : ",", event.Name, own->Thread, event.Start / 1000.0, event.Duration / 1000.0);
+				else
+					length += snprintf(buffer + length, sizeof(buffer) - length,
+						"%s\n{\"name\":\"%.200s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%ld}}",
+						first ? "" : ",", event.Name, own->Thread, event.Start / 1000.0, event.Value);
+				first = false;
+			}
+		}
+		pthread_mutex_unlock(&Lock);
+
+		length += snprintf(buffer + length, sizeof(buffer) - length, "\n]}\n");
+
+		return ok && Render::emit(fd, buffer, length);
+	}
+
+	/**
+	 * Writes the events of every thread to a file, as dump() does.
+	 * \arg		path	the file, created or truncated
+	 * \return	false if it couldn't be written
+	 */
+	bool Trace::save(const char* path) {
+		int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		bool ok;
+
+		if(fd < 0)
+			return false;
+
+		ok = dump(fd);
+		return close(fd) == 0 && ok;
+	}
+
+	/**
+	 * Forgets the events recorded so far. It must not be called while other threads are recording.
+	 */
+	void Trace::clear() {
+		pthread_mutex_lock(&Lock);
+		for(TraceBuffer* own = Buffers; own != 0; own = own->Next)
+			own->Written = 0;
+		pthread_mutex_unlock(&Lock);
+	}
+
+	/**
+	 * Starts a span.
+	 * \arg		name	name of the span; it must be a string literal
+	 */
+	TraceSpan::TraceSpan(const char* name)
+		: Name(name), Start(Trace::now())
+	{
+	}
+
+	/**
+	 * Ends the span, recording it.
+	 */
+	TraceSpan::~TraceSpan() {
+		Trace::record(Name, 'X', Start, Trace::now() - Start, 0);
+	}
+}
+}
@@ -0,0 +1,93 @@
+// See COPYING file for licensing information.
+/**
+ * \file trace.h
+ * Definition of the optional timeline of the solver phases, exported as Chrome trace events.
+ *
+ * The SUDOKU_TRACE_SPAN and SUDOKU_TRACE_EVENT macros only record anything if SUDOKU_TRACE is
+ * defined when compiling (scons trace=1); otherwise they expand to nothing. The timeline, which
+ * the -t option of sudokizer and sudokubench writes, can be loaded in chrome://tracing or any
+ * viewer of the Trace Event Format.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+
+#define SUDOKU_TRACE_JOIN2(a, b)	a##b
+#define SUDOKU_TRACE_JOIN(a, b)		SUDOKU_TRACE_JOIN2(a, b)
+
+#ifdef SUDOKU_TRACE
+// Records a span from here to the end of the enclosing block
+#define SUDOKU_TRACE_SPAN(name)				std::sudoku::TraceSpan SUDOKU_TRACE_JOIN(traceSpan, __LINE__)(name)
+// Records an instant event with a value
+#define SUDOKU_TRACE_EVENT(name, value)		std::sudoku::Trace::instant(name, value)
+#else
+// Statements doing nothing, so that they still need their semicolon and can be an if body
+#define SUDOKU_TRACE_SPAN(name)				do {} while(0)
+#define SUDOKU_TRACE_EVENT(name, value)		do {} while(0)
+#endif
+
+namespace std {
+namespace sudoku {
+	/**
+	 * A recorded event: a span ('X') with its duration, or an instant ('i') with a value.
+	 * Names are string literals, so only their address is stored.
+	 */
+	typedef struct {
+		const char* Name;
+		char Phase;
+		long Value;
+		unsigned long long Start, Duration;
+	} TraceEvent;
+
+	/**
+	 * Ring buffer of the events of a thread. When it's full the oldest events are overwritten.
+	 */
+	class TraceBuffer {
+	public:
+		static const size_t Capacity = 65536;
+
+		TraceEvent Events[Capacity];
+		unsigned long long Written;
+		short unsigned int Thread;
+		bool Free;			// its thread has exited, so another one may take it
+		TraceBuffer* Next;
+	};
+
+	/**
+	 * Recorder of the timeline. Each thread writes to its own buffer, taken the first time it
+	 * records an event, so recording never takes a lock. When a thread exits its buffer keeps its
+	 * events and goes to the next thread needing one, which appends to them: the engines start
+	 * new threads on every call, and there are only ever as many buffers as threads recording at
+	 * the same time. They are all written out by dump() once the work is done.
+	 */
+	class Trace {
+		Trace();
+
+		static TraceBuffer* buffer();
+	public:
+		static bool enabled();
+		static unsigned long long now();
+		static void record(const char* name, char phase, unsigned long long start, unsigned long long duration, long value);
+		static void instant(const char* name, long value = 0);
+		static bool dump(int fd);
+		static bool save(const char* path);
+		static void clear();
+	};
+
+	/**
+	 * Span recorded from its construction to its destruction.
+	 */
+	class TraceSpan {
+		const char* Name;
+		unsigned long long Start;
+
+		TraceSpan(const TraceSpan& copy);
+	public:
+		TraceSpan(const char* name);
+		~TraceSpan();
+	};
+}
+}
+#endif
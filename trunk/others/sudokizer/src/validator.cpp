@@ -0,0 +1,228 @@
+// See COPYING file for licensing information.
+/**
+ * \file validator.cpp
+ * Implementation of the bulk checking of completed grids.
+ */
+#include "validator.h"
+#include "tables.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Returns the bit of a digit character, or 0 if it isn't one of 1 to 9.
+	 */
+	static inline short unsigned int digitBit(char digit) {
+		unsigned int d = static_cast<unsigned char>(digit) - '1';
+
+		return (d < 9) << (d & 15);
+	}
+
+	/**
+	 * Checks a single completed grid.
+	 * \arg		grid	81 characters, row by row
+	 * \return	true if every row, column and box holds the digits 1 to 9
+	 */
+	bool Validator::check(const char* grid) {
+		short unsigned int bits[81], wrong = 0;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			bits[c] = digitBit(grid[c]);
+
+		for(short unsigned int u = 0; u < 27; u++) {
+			const unsigned char* unit = UnitCells[u];
+
+			wrong |= (bits[unit[0]] | bits[unit[1]] | bits[unit[2]] | bits[unit[3]] | bits[unit[4]] |
+				bits[unit[5]] | bits[unit[6]] | bits[unit[7]] | bits[unit[8]]) ^ 0x1FF;
+		}
+
+		return wrong == 0;
+	}
+
+#if defined(__SSE2__)
+	/**
+	 * The 16 characters of a chunk of a grid: with AVX2 two grids at once, one per half, since the
+	 * shifts and the shuffles of AVX2 work on each half of 16 bytes on its own.
+	 */
+	// bytes: every byte set to a value; above: how much each byte is above another, 0 if it isn't;
+	// mask: the top bit of each byte; down and up: shifts by bytes; join: 16 bytes taken from the
+	// bytes n on of lo, followed by hi; lookup: the byte of a table picked by the 4 low bits of each
+	// byte; sums: the sum of the bytes of each grid
+#if defined(__AVX2__)
+	typedef __m256i Bytes;
+	static const short unsigned int Grids = 2;
+
+	static inline Bytes load(const char* a, const char* b) {
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a))),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)), 1);
+	}
+	static inline Bytes bytes(char v) { return _mm256_set1_epi8(v); }
+	static inline Bytes orBytes(Bytes a, Bytes b) { return _mm256_or_si256(a, b); }
+	static inline Bytes andBytes(Bytes a, Bytes b) { return _mm256_and_si256(a, b); }
+	static inline Bytes subBytes(Bytes a, Bytes b) { return _mm256_sub_epi8(a, b); }
+	static inline Bytes above(Bytes a, Bytes b) { return _mm256_subs_epu8(a, b); }
+	static inline Bytes equal(Bytes a, Bytes b) { return _mm256_cmpeq_epi8(a, b); }
+	static inline unsigned int mask(Bytes a) { return _mm256_movemask_epi8(a); }
+	template<int n> static inline Bytes down(Bytes a) { return _mm256_srli_si256(a, n); }
+	template<int n> static inline Bytes up(Bytes a) { return _mm256_slli_si256(a, n); }
+	template<int n> static inline Bytes join(Bytes lo, Bytes hi) { return _mm256_alignr_epi8(hi, lo, n); }
+	static inline Bytes lookup(Bytes d) {
+		return _mm256_shuffle_epi8(_mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+			1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0), d);
+	}
+	static inline void sums(Bytes a, short unsigned int* grids) {
+		__m256i s = _mm256_sad_epu8(a, _mm256_setzero_si256());
+
+		grids[0] = _mm256_extract_epi64(s, 0) + _mm256_extract_epi64(s, 1);
+		grids[1] = _mm256_extract_epi64(s, 2) + _mm256_extract_epi64(s, 3);
+	}
+#else
+	typedef __m128i Bytes;
+	static const short unsigned int Grids = 1;
+
+	static inline Bytes load(const char* a, const char*) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(a)); }
+	static inline Bytes bytes(char v) { return _mm_set1_epi8(v); }
+	static inline Bytes orBytes(Bytes a, Bytes b) { return _mm_or_si128(a, b); }
+	static inline Bytes andBytes(Bytes a, Bytes b) { return _mm_and_si128(a, b); }
+	static inline Bytes subBytes(Bytes a, Bytes b) { return _mm_sub_epi8(a, b); }
+	static inline Bytes above(Bytes a, Bytes b) { return _mm_subs_epu8(a, b); }
+	static inline Bytes equal(Bytes a, Bytes b) { return _mm_cmpeq_epi8(a, b); }
+	static inline unsigned int mask(Bytes a) { return _mm_movemask_epi8(a); }
+	template<int n> static inline Bytes down(Bytes a) { return _mm_srli_si128(a, n); }
+	template<int n> static inline Bytes up(Bytes a) { return _mm_slli_si128(a, n); }
+#if defined(__SSSE3__)
+	template<int n> static inline Bytes join(Bytes lo, Bytes hi) { return _mm_alignr_epi8(hi, lo, n); }
+	static inline Bytes lookup(Bytes d) {
+		return _mm_shuffle_epi8(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0), d);
+	}
+#else
+	template<int n> static inline Bytes join(Bytes lo, Bytes hi) { return _mm_or_si128(_mm_srli_si128(lo, n), _mm_slli_si128(hi, 16 - n)); }
+#endif
+	static inline void sums(Bytes a, short unsigned int* grids) {
+		__m128i s = _mm_sad_epu8(a, _mm_setzero_si128());
+
+		grids[0] = _mm_cvtsi128_si32(s) + _mm_extract_epi16(s, 4);
+	}
+#endif
+
+	/**
+	 * Returns the row of a grid starting at a cell, in the first 9 bytes, out of the chunks of 16
+	 * cells.
+	 */
+	template<int c> static inline Bytes row(const Bytes* chunks) {
+		return c % 16 == 0 ? chunks[c / 16] : join<c % 16>(chunks[c / 16], chunks[c / 16 + 1]);
+	}
+
+	/**
+	 * Returns the bits of the cells of a chunk from their digits less '1': the bit of the digit for
+	 * 1 to 8, none for 9, and anything for the characters which aren't digits.
+	 */
+	static inline Bytes digitBits(Bytes d) {
+#if defined(__SSSE3__)
+		return lookup(d);
+#else
+		// 1 << d by its bits: 1 or 2, times 4 if d has bit 1, times 16 if it has bit 2
+		Bytes one = bytes(1), x = _mm_add_epi8(one, andBytes(d, one));
+		Bytes two = equal(andBytes(d, bytes(2)), bytes(2)), four = equal(andBytes(d, bytes(4)), bytes(4));
+
+		x = orBytes(_mm_andnot_si128(two, x), andBytes(two, _mm_slli_epi16(x, 2)));
+		x = orBytes(_mm_andnot_si128(four, x), andBytes(four, _mm_slli_epi16(x, 4)));
+		return _mm_andnot_si128(equal(d, bytes(8)), x);
+#endif
+	}
+
+	/**
+	 * Checks the grids of a step, Grids of them.
+	 * Every unit has to hold the digits 1 to 8, which take a byte, and then the grid is valid if
+	 * each of its cells is a digit and 9 of them are 9: a unit holding 1 to 8 has room for one 9 at
+	 * most, so each row, column and box gets one.
+	 * \arg		grids	the first character of each grid
+	 * \arg		valid	set for each grid to whether it's valid
+	 */
+	static inline void checkStep(const char* const* grids, bool* valid) {
+		const char* a = grids[0];
+		const char* b = grids[Grids - 1];
+		Bytes chunks[6], wrong = bytes(0), nines = bytes(0);
+
+		for(short unsigned int i = 0; i < 6; i++) {
+			// The last chunk only holds the last cell, followed by 1s which don't change anything
+			Bytes text = i < 5 ? load(a + i * 16, b + i * 16) : orBytes(down<15>(load(a + 65, b + 65)), up<1>(bytes('1')));
+			Bytes d = subBytes(text, bytes('1'));
+
+			wrong = orBytes(wrong, above(d, bytes(8)));
+			nines = subBytes(nines, equal(text, bytes('9')));
+			chunks[i] = digitBits(d);
+		}
+
+		// Rows and boxes by shifting the bytes of a row onto its first ones: the triples of cells
+		// of each box land on bytes 0, 3 and 6, then the whole row on byte 0
+		Bytes r0 = row<0>(chunks), r1 = row<9>(chunks), r2 = row<18>(chunks), r3 = row<27>(chunks),
+			r4 = row<36>(chunks), r5 = row<45>(chunks), r6 = row<54>(chunks), r7 = row<63>(chunks),
+			r8 = row<72>(chunks);
+		Bytes columns = orBytes(orBytes(orBytes(r0, r1), orBytes(r2, r3)), orBytes(orBytes(r4, r5), orBytes(orBytes(r6, r7), r8)));
+		Bytes triples[9] = {r0, r1, r2, r3, r4, r5, r6, r7, r8}, rows = bytes(-1), boxes = bytes(-1);
+
+		for(short unsigned int r = 0; r < 9; r++) {
+			triples[r] = orBytes(triples[r], orBytes(down<1>(triples[r]), down<2>(triples[r])));
+			rows = andBytes(rows, orBytes(triples[r], orBytes(down<3>(triples[r]), down<6>(triples[r]))));
+		}
+		for(short unsigned int band = 0; band < 9; band += 3)
+			boxes = andBytes(boxes, orBytes(triples[band], orBytes(triples[band + 1], triples[band + 2])));
+
+		// Columns in bytes 0 to 8, rows in byte 0 and boxes in bytes 0, 3 and 6 hold 1 to 8
+		unsigned int full = mask(equal(columns, bytes(-1))) & (mask(equal(rows, bytes(-1))) | ~0x00010001u) &
+			(mask(equal(boxes, bytes(-1))) | ~0x00490049u), digits = mask(equal(wrong, bytes(0)));
+		short unsigned int count[Grids];
+
+		sums(nines, count);
+		for(short unsigned int g = 0; g < Grids; g++)
+			valid[g] = ((full >> (16 * g)) & 0x1FF) == 0x1FF && ((digits >> (16 * g)) & 0xFFFF) == 0xFFFF &&
+				count[g] == 9;
+	}
+#endif
+
+	/**
+	 * Checks many completed grids.
+	 * \arg		grids	the grids, each one made of 81 characters row by row
+	 * \arg		count	number of grids
+	 * \arg		valid	set for every grid to whether every row, column and box holds the digits
+	 *					1 to 9
+	 * \arg		stride	distance from the start of a grid to the next one, 82 for lines of text
+	 * \return	number of valid grids
+	 */
+	size_t Validator::check(const char* grids, size_t count, bool* valid, size_t stride) {
+		size_t found = 0;
+
+#if defined(__SSE2__)
+		for(size_t first = 0; first < count; first += Grids) {
+			const char* step[Grids];
+			bool checked[Grids];
+
+			// The grids left over are checked again with the last one
+			for(short unsigned int g = 0; g < Grids; g++)
+				step[g] = grids + (first + g < count ? first + g : count - 1) * stride;
+
+			checkStep(step, checked);
+			for(short unsigned int g = 0; g < Grids && first + g < count; g++) {
+				valid[first + g] = checked[g];
+				found += checked[g];
+			}
+		}
+#else
+		for(size_t i = 0; i < count; i++) {
+			valid[i] = check(grids + i * stride);
+			found += valid[i];
+		}
+#endif
+
+		return found;
+	}
+}
+}
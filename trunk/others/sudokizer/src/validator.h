@@ -0,0 +1,32 @@
+// See COPYING file for licensing information.
+/**
+ * \file validator.h
+ * Definition of the bulk checking of completed grids with SIMD instructions.
+ */
+
+#ifndef VALIDATOR_H
+#define VALIDATOR_H
+
+#include <cstddef>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Checker of completed grids, for bulk workloads such as submitted solutions.
+	 * Grids are read as text, 81 characters row by row, and a grid is valid if every row, column
+	 * and box holds the digits 1 to 9. No Board is built: every cell becomes its digit's bit and
+	 * each unit is the OR of its 9 cells, which must have the 9 bits set; any other character sets
+	 * no bit, so it makes its units fail. In bulk, with SSE2, the characters of a grid are read 16
+	 * at a time and turned into their bits together; the units are ORed by shifting the rows onto
+	 * each other, and with AVX2 two grids are checked at once. There isn't a single branch
+	 * depending on the grids.
+	 */
+	class Validator {
+		Validator();
+	public:
+		static bool check(const char* grid);
+		static size_t check(const char* grids, size_t count, bool* valid, size_t stride = 81);
+	};
+}
+}
+#endif
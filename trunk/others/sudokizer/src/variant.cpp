@@ -0,0 +1,452 @@
+// See COPYING file for licensing information.
+/**
+ * \file variant.cpp
+ * Implementation of the engine solving sudoku variants with extra units and killer cages.
+ */
+#include "variant.h"
+#include "tables.h"
+#include "trace.h"
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Values which can fill a cage: for every number of cells, sum and mask of values available,
+	 * the union of the sets of that many different available values with that sum.
+	 */
+	static short unsigned int CageTable[10][46][512];
+
+	/**
+	 * Fills the cage table at startup. Every set of values is added to the masks containing it,
+	 * which are 3^9 pairs in all.
+	 */
+	static struct CageTableInitializer {
+		CageTableInitializer() {
+			for(short unsigned int set = 1; set < 512; set++) {
+				short unsigned int size = __builtin_popcount(set), sum = 0, others = 511 & ~set;
+
+				for(short unsigned int v = 0; v < 9; v++)
+					if(set & (1 << v))
+						sum += v + 1;
+
+				for(short unsigned int more = others; ; more = (more - 1) & others) {
+					CageTable[size][sum][set | more] |= set;
+					if(more == 0)
+						break;
+				}
+			}
+		}
+	} cageTableInitializer;
+
+	/**
+	 * Variant constructor. It starts with the rules of the classic sudoku.
+	 */
+	Variant::Variant() {
+		for(short unsigned int c = 0; c < 81; c++)
+			CellCage[c] = -1;
+
+		for(short unsigned int u = 0; u < 27; u++)
+			addUnit(UnitCells[u]);
+	}
+
+	/**
+	 * Makes the given cells peers of each other.
+	 */
+	void Variant::link(const vector<unsigned char>& cells) {
+		for(size_t i = 0; i < cells.size(); i++)
+			for(size_t j = 0; j < cells.size(); j++) {
+				vector<unsigned char>& peers = CellPeers[cells[i]];
+				size_t k = 0;
+
+				while(k < peers.size() && peers[k] != cells[j])
+					k++;
+				if(i != j && k == peers.size())
+					peers.push_back(cells[j]);
+			}
+	}
+
+	/**
+	 * Adds a unit, which holds every value once.
+	 * \arg		cells	the 9 cells of the unit
+	 * \return	false if some cell is repeated or out of the board
+	 */
+	bool Variant::addUnit(const unsigned char* cells) {
+		short unsigned int seen[81] = {0};
+
+		for(short unsigned int i = 0; i < 9; i++)
+			if(cells[i] >= 81 || seen[cells[i]]++)
+				return false;
+
+		Units.push_back(vector<unsigned char>(cells, cells + 9));
+		for(short unsigned int i = 0; i < 9; i++)
+			CellUnits[cells[i]].push_back(Units.size() - 1);
+		link(Units.back());
+
+		return true;
+	}
+
+	/**
+	 * Adds the two diagonals of the X-sudoku as units.
+	 */
+	void Variant::addDiagonals() {
+		unsigned char main[9], anti[9];
+
+		for(short unsigned int i = 0; i < 9; i++) {
+			main[i] = i * 10;
+			anti[i] = i * 8 + 8;
+		}
+
+		addUnit(main);
+		addUnit(anti);
+	}
+
+	/**
+	 * Adds the four windows of the windoku as units: the 3x3 squares starting at rows and
+	 * columns 1 and 5.
+	 */
+	void Variant::addWindows() {
+		for(short unsigned int w = 0; w < 4; w++) {
+			unsigned char window[9];
+
+			for(short unsigned int i = 0; i < 9; i++)
+				window[i] = (1 + (w / 2) * 4 + i / 3) * 9 + 1 + (w % 2) * 4 + i % 3;
+
+			addUnit(window);
+		}
+	}
+
+	/**
+	 * Adds a killer cage, whose cells hold different values adding up to a sum.
+	 * \arg		cells	the cells of the cage
+	 * \arg		size	number of cells, in the range [1,9]
+	 * \arg		sum		sum of their values
+	 * \return	false if some cell is repeated, out of the board or already in a cage, or if no
+	 *			set of different values has this size and sum
+	 */
+	bool Variant::addCage(const unsigned char* cells, short unsigned int size, short unsigned int sum) {
+		if(size == 0 || size > 9 || sum > 45 || cageOptions(size, sum, 511) == 0)
+			return false;
+
+		for(short unsigned int i = 0; i < size; i++) {
+			if(cells[i] >= 81 || CellCage[cells[i]] >= 0)
+				return false;
+			for(short unsigned int j = 0; j < i; j++)
+				if(cells[i] == cells[j])
+					return false;
+		}
+
+		Cage cage;
+
+		cage.Cells.assign(cells, cells + size);
+		cage.Sum = sum;
+		Cages.push_back(cage);
+		for(short unsigned int i = 0; i < size; i++)
+			CellCage[cells[i]] = Cages.size() - 1;
+		link(cage.Cells);
+
+		return true;
+	}
+
+	/**
+	 * Returns the number of units, the 27 classic ones included.
+	 */
+	size_t Variant::units() const {
+		return Units.size();
+	}
+
+	/**
+	 * Returns the number of killer cages.
+	 */
+	size_t Variant::cages() const {
+		return Cages.size();
+	}
+
+	/**
+	 * Returns the values which can fill some cells of a cage.
+	 * \arg		size		number of cells, in the range [0,9]
+	 * \arg		sum			sum their values must reach
+	 * \arg		available	mask of the values they may take
+	 * \return	mask of the values in some set of size different available values adding up to sum
+	 */
+	short unsigned int Variant::cageOptions(short unsigned int size, short unsigned int sum,
+		short unsigned int available)
+	{
+		if(size > 9 || sum > 45)
+			return 0;
+
+		return CageTable[size][sum][available & 511];
+	}
+
+	/**
+	 * Sets the definitive value of a cell and propagates it, like Grid::assign, to its peers and
+	 * to its cage.
+	 * \return	false if it leads to a contradiction
+	 */
+	bool Variant::assign(VariantGrid& grid, short unsigned int cell, short unsigned int myP) const {
+		short unsigned int bit = 1 << (myP - 1);
+
+		if(!(grid.Candidates[cell] & bit))
+			return false;
+		else if(grid.Values[cell] == myP)
+			return true;
+
+		grid.Values[cell] = myP;
+		grid.Unsolved--;
+
+		for(short unsigned int others = grid.Candidates[cell] & ~bit; others; others &= others - 1)
+			if(!eliminate(grid, cell, __builtin_ctz(others) + 1))
+				return false;
+
+		const vector<unsigned char>& peers = CellPeers[cell];
+
+		for(size_t i = 0; i < peers.size(); i++)
+			if(!eliminate(grid, peers[i], myP))
+				return false;
+
+		return CellCage[cell] < 0 || constrain(grid, CellCage[cell]);
+	}
+
+	/**
+	 * Removes a candidate from a cell and propagates it, like Grid::eliminate, to the units and to
+	 * the cage of the cell.
+	 * \return	false if the cell or one of its units is left with no place for a value, or its cage
+	 *			can't be filled
+	 */
+	bool Variant::eliminate(VariantGrid& grid, short unsigned int cell, short unsigned int myP) const {
+		short unsigned int bit = 1 << (myP - 1);
+
+		if(!(grid.Candidates[cell] & bit))
+			return true;
+
+		grid.Candidates[cell] &= ~bit;
+
+		if(grid.Candidates[cell] == 0)
+			return false;
+		else if(grid.Values[cell] == 0 && !(grid.Candidates[cell] & (grid.Candidates[cell] - 1))
+			&& !assign(grid, cell, __builtin_ctz(grid.Candidates[cell]) + 1))
+			return false;
+
+		const vector<unsigned char>& units = CellUnits[cell];
+
+		for(size_t u = 0; u < units.size(); u++) {
+			const vector<unsigned char>& unit = Units[units[u]];
+			short unsigned int places = 0, place = 0;
+
+			for(short unsigned int i = 0; i < 9 && places < 2; i++)
+				if(grid.Candidates[unit[i]] & bit) {
+					places++;
+					place = unit[i];
+				}
+
+			if(places == 0)
+				return false;
+			else if(places == 1 && grid.Values[place] == 0 && !assign(grid, place, myP))
+				return false;
+		}
+
+		return CellCage[cell] < 0 || grid.Values[cell] != 0 || constrain(grid, CellCage[cell]);
+	}
+
+	/**
+	 * Keeps in the undecided cells of a cage only the values which can still fill it, looked up
+	 * in the cage table.
+	 * \return	false if the cage can't be filled
+	 */
+	bool Variant::constrain(VariantGrid& grid, short unsigned int cage) const {
+		const vector<unsigned char>& cells = Cages[cage].Cells;
+		short int sum = Cages[cage].Sum;
+		short unsigned int left = 0, used = 0, available = 0;
+
+		for(size_t i = 0; i < cells.size(); i++) {
+			short unsigned int c = cells[i];
+
+			if(grid.Values[c] != 0) {
+				sum -= grid.Values[c];
+				used |= 1 << (grid.Values[c] - 1);
+			} else {
+				left++;
+				available |= grid.Candidates[c];
+			}
+		}
+
+		if(left == 0)
+			return sum == 0;
+		else if(sum <= 0)
+			return false;
+
+		short unsigned int allowed = cageOptions(left, sum, available & ~used);
+
+		if(allowed == 0)
+			return false;
+
+		for(size_t i = 0; i < cells.size(); i++) {
+			short unsigned int c = cells[i];
+
+			if(grid.Values[c] == 0)
+				for(short unsigned int extra = grid.Candidates[c] & ~allowed; extra; extra &= extra - 1)
+					if(!eliminate(grid, c, __builtin_ctz(extra) + 1))
+						return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Chooses the undecided cell with the fewest candidates, like Grid::choose.
+	 * \return	index of the chosen cell, or 81 if every cell is decided
+	 */
+	short unsigned int Variant::choose(const VariantGrid& grid) const {
+		short unsigned int best = 81, fewest = 10;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(grid.Values[c] == 0) {
+				short unsigned int n = __builtin_popcount(grid.Candidates[c]);
+
+				if(n < fewest) {
+					fewest = n;
+					best = c;
+					if(n == 2)
+						break;
+				}
+			}
+
+		return best;
+	}
+
+	/**
+	 * Builds the state of a puzzle: the givens are set and every cage is propagated.
+	 * \arg		values	the 81 cells, row by row, 0 for the empty ones
+	 * \return	false if it's a contradiction
+	 */
+	bool Variant::load(const short unsigned int* values, VariantGrid& grid) const {
+		grid.Unsolved = 81;
+		for(short unsigned int c = 0; c < 81; c++) {
+			grid.Candidates[c] = 511;
+			grid.Values[c] = 0;
+		}
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(values[c] > 9 || (values[c] != 0 && !assign(grid, c, values[c])))
+				return false;
+
+		for(short unsigned int k = 0; k < Cages.size(); k++)
+			if(!constrain(grid, k))
+				return false;
+
+		return true;
+	}
+
+	/**
+	 * Depth-first search of the first solution.
+	 * \arg		grid	state to solve; on success it's replaced by the solution
+	 * \arg		budget	limits of the search, spending a node per branch
+	 */
+	bool Variant::first(VariantGrid& grid, Budget& budget) const {
+		if(grid.Unsolved == 0)
+			return true;
+
+		if(!budget.spend())
+			return false;
+
+		short unsigned int cell = choose(grid), mask = grid.Candidates[cell];
+
+		SUDOKU_TRACE_EVENT("branch", cell);
+		for(; mask; mask &= mask - 1) {
+			VariantGrid child = grid;
+
+			if(assign(child, cell, __builtin_ctz(mask) + 1) && first(child, budget)) {
+				grid = child;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Depth-first count of the solutions.
+	 * \arg		grid	state whose solutions are counted
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \arg		found	counter of solutions found so far
+	 * \arg		budget	limits of the search, spending a node per branch
+	 */
+	void Variant::tally(const VariantGrid& grid, unsigned long limit, unsigned long& found, Budget& budget) const {
+		if(grid.Unsolved == 0) {
+			found++;
+			return;
+		}
+
+		if(!budget.spend())
+			return;
+
+		short unsigned int cell = choose(grid), mask = grid.Candidates[cell];
+
+		for(; mask && (limit == 0 || found < limit); mask &= mask - 1) {
+			VariantGrid child = grid;
+
+			if(assign(child, cell, __builtin_ctz(mask) + 1))
+				tally(child, limit, found, budget);
+		}
+	}
+
+	/**
+	 * Solves a puzzle of the variant.
+	 * \arg		values	the 81 cells, row by row, 0 for the empty ones; on success they are all set
+	 * \return	true if the puzzle has a solution
+	 */
+	bool Variant::solve(short unsigned int* values) const {
+		Budget unlimited;
+
+		return solve(values, unlimited);
+	}
+
+	/**
+	 * Solves a puzzle of the variant within a budget.
+	 * \arg		values	the 81 cells, row by row, 0 for the empty ones; on success they are all set
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \return	true if a solution was found; if not, budget.exceeded() tells whether the puzzle has
+	 *			no solution or the search was stopped
+	 */
+	bool Variant::solve(short unsigned int* values, Budget& budget) const {
+		SUDOKU_TRACE_SPAN("variant");
+		VariantGrid grid;
+
+		if(!load(values, grid) || !first(grid, budget))
+			return false;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			values[c] = grid.Values[c];
+
+		return true;
+	}
+
+	/**
+	 * Counts the solutions of a puzzle of the variant.
+	 * \arg		values	the 81 cells, row by row, 0 for the empty ones
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \return	number of solutions found, which is at most limit if a limit was given
+	 */
+	unsigned long Variant::count(const short unsigned int* values, unsigned long limit) const {
+		Budget unlimited;
+
+		return count(values, unlimited, limit);
+	}
+
+	/**
+	 * Counts the solutions of a puzzle of the variant within a budget.
+	 * \arg		values	the 81 cells, row by row, 0 for the empty ones
+	 * \arg		budget	limits of the search, spending a node per branch
+	 * \arg		limit	stop once this number of solutions is reached, or 0 to count them all
+	 * \return	number of solutions found, which is at most limit if a limit was given; if
+	 *			budget.exceeded() it's only a lower bound
+	 */
+	unsigned long Variant::count(const short unsigned int* values, Budget& budget, unsigned long limit) const {
+		VariantGrid grid;
+		unsigned long found = 0;
+
+		if(load(values, grid))
+			tally(grid, limit, found, budget);
+
+		return found;
+	}
+}
+}
@@ -0,0 +1,79 @@
+// See COPYING file for licensing information.
+/**
+ * \file variant.h
+ * Definition of the engine solving sudoku variants with extra units and killer cages.
+ */
+
+#ifndef VARIANT_H
+#define VARIANT_H
+
+#include "sudoku.h"
+#include "budget.h"
+#include <vector>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Candidates state of a variant board, kept as bitmasks like in Grid.
+	 */
+	typedef struct {
+		short unsigned int Candidates[81];
+		short unsigned int Values[81];
+		short unsigned int Unsolved;
+	} VariantGrid;
+
+	/**
+	 * Killer cage: cells which hold different values adding up to Sum.
+	 */
+	typedef struct {
+		vector<unsigned char> Cells;
+		short unsigned int Sum;
+	} Cage;
+
+	/**
+	 * Rules of a sudoku variant and backtracking search solving it.
+	 * The rules are data instead of being wired in: a list of units, each of them holding every
+	 * value once, which starts with the 27 rows, columns and boxes of tables.h and may get the
+	 * diagonals (X-sudoku), the four windows (windoku) or any other unit; and a list of killer
+	 * cages. The peers of every cell are derived from them.
+	 * A cage is propagated by looking up the values which can still fill it, given how many of its
+	 * cells are undecided, the sum they must reach and the values left for them, in a table built
+	 * once for every such combination; so it costs the same as a unit instead of enumerating the
+	 * combinations of the cage.
+	 */
+	class Variant {
+		vector< vector<unsigned char> > Units;
+		vector<Cage> Cages;
+		vector<unsigned char> CellUnits[81];
+		vector<unsigned char> CellPeers[81];
+		short int CellCage[81];
+
+		void link(const vector<unsigned char>& cells);
+		bool assign(VariantGrid& grid, short unsigned int cell, short unsigned int myP) const;
+		bool eliminate(VariantGrid& grid, short unsigned int cell, short unsigned int myP) const;
+		bool constrain(VariantGrid& grid, short unsigned int cage) const;
+		short unsigned int choose(const VariantGrid& grid) const;
+		bool load(const short unsigned int* values, VariantGrid& grid) const;
+		bool first(VariantGrid& grid, Budget& budget) const;
+		void tally(const VariantGrid& grid, unsigned long limit, unsigned long& found, Budget& budget) const;
+	public:
+		Variant();
+
+		bool addUnit(const unsigned char* cells);
+		void addDiagonals();
+		void addWindows();
+		bool addCage(const unsigned char* cells, short unsigned int size, short unsigned int sum);
+		size_t units() const;
+		size_t cages() const;
+
+		bool solve(short unsigned int* values) const;
+		bool solve(short unsigned int* values, Budget& budget) const;
+		unsigned long count(const short unsigned int* values, unsigned long limit = 0) const;
+		unsigned long count(const short unsigned int* values, Budget& budget, unsigned long limit = 0) const;
+
+		static short unsigned int cageOptions(short unsigned int size, short unsigned int sum,
+			short unsigned int available);
+	};
+}
+}
+#endif
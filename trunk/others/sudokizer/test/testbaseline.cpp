@@ -0,0 +1,211 @@
+// See COPYING file for licensing information.
+/**
+ * \file testbaseline.cpp
+ * Performance regression tests of the engines.
+ */
+
+#include "testsudoku.h"
+#include "search.h"
+#include "backjump.h"
+#include "sat.h"
+#include "batch.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <unistd.h>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Returns the time of a monotonic clock in seconds.
+	 */
+	static double now() {
+		timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+
+	/**
+	 * Times an engine over the corpus. Each of three runs goes through the corpus for a quarter of a
+	 * second at least, and the fastest one is kept, as the least disturbed by the rest of the machine.
+	 * \arg		engine	search, backjump, sat or batch
+	 * \arg		corpus	the 81 cells of the puzzles
+	 * \arg		nodes	set to the nodes spent over the corpus; those of the batch are the nodes of
+	 *					the searches finishing the puzzles its lanes don't solve
+	 * \return	the puzzles per second of the fastest run
+	 */
+	double TestBaseline::speed(const string& engine, const vector<short unsigned int>& corpus, unsigned long& nodes) {
+		size_t count = corpus.size() / 81;
+		vector<Grid> grids(count);
+		vector<char> lines(count * 82), out(count * 82);
+		double best = 0;
+
+		for(size_t p = 0; p < count; p++) {
+			for(short unsigned int c = 0; c < 81; c++) {
+				if(corpus[p * 81 + c] != 0)
+					grids[p].assign(c, corpus[p * 81 + c]);
+				lines[p * 82 + c] = '0' + corpus[p * 81 + c];
+			}
+			lines[p * 82 + 81] = '\n';
+		}
+
+		for(short unsigned int run = 0; run < 3; run++) {
+			double start = now(), seconds;
+			unsigned long passes = 0;
+
+			do {
+				nodes = 0;
+				if(engine == "batch") {
+					Batch batch;
+					Budget budget;
+
+					batch.solve(&lines[0], count, &out[0], budget);
+					nodes = budget.getNodes();
+				} else {
+					for(size_t p = 0; p < count; p++) {
+						Grid grid = grids[p];
+						Budget budget;
+
+						if(engine == "search")
+							Search::solve(grid, budget);
+						else if(engine == "backjump")
+							Backjumper::solve(grid, budget);
+						else {
+							Board Sudoku;
+
+							grid.store(Sudoku);
+							SatSolver::solve(Sudoku, budget);
+						}
+						nodes += budget.getNodes();
+					}
+				}
+
+				passes++;
+				seconds = now() - start;
+			} while(seconds < 0.25);
+
+			if(passes * count / seconds > best)
+				best = passes * count / seconds;
+		}
+
+		return best;
+	}
+
+	/**
+	 * Measures the speed of the engines over the corpus.
+	 * \arg		corpus		the 81 cells of the puzzles
+	 * \arg		measures	set to the speed of each engine
+	 */
+	void TestBaseline::measure(const vector<short unsigned int>& corpus, vector<Measure>& measures) {
+		static const char* engines[] = {"search", "backjump", "sat", "batch"};
+
+		measures.clear();
+		for(short unsigned int e = 0; e < 4; e++) {
+			Measure measure;
+
+			measure.Engine = engines[e];
+			measure.Rate = speed(engines[e], corpus, measure.Nodes);
+			measures.push_back(measure);
+		}
+	}
+
+	/**
+	 * Returns the name of the machine the tests run on, which the baselines record.
+	 */
+	string TestBaseline::machine() {
+		char name[256];
+
+		if(gethostname(name, sizeof(name)) != 0)
+			return "unknown";
+		name[sizeof(name) - 1] = 0;
+
+		return name;
+	}
+
+	/**
+	 * Reads a baseline: a line "machine <name>" with the machine it was measured on, then a line
+	 * per engine with its name, its puzzles per second and its nodes; the lines starting with '#'
+	 * are comments.
+	 * \arg		path		the file
+	 * \arg		baseline	set to the speed of each engine
+	 * \arg		host		set to the machine it was measured on, or empty if it doesn't say
+	 * \return	false if the file can't be read or holds no engine
+	 */
+	bool TestBaseline::load(const char* path, vector<Measure>& baseline, string& host) {
+		ifstream file(path);
+		string line;
+
+		baseline.clear();
+		host.clear();
+		while(getline(file, line)) {
+			istringstream fields(line);
+			Measure measure;
+
+			if(line.empty() || line[0] == '#')
+				continue;
+			if(line.compare(0, 8, "machine ") == 0)
+				host = line.substr(8);
+			else if(fields >> measure.Engine >> measure.Rate >> measure.Nodes)
+				baseline.push_back(measure);
+		}
+
+		return !baseline.empty();
+	}
+
+	/**
+	 * Writes a baseline, measured on this machine.
+	 * \arg		path		the file
+	 * \arg		measures	the speed of each engine
+	 * \return	false if the file can't be written
+	 */
+	bool TestBaseline::save(const char* path, const vector<Measure>& measures) {
+		ofstream file(path);
+
+		file << "# engine, puzzles per second and nodes over the corpus, as testsudoku -u records them" << endl
+			<< "machine " << machine() << endl;
+		for(size_t m = 0; m < measures.size(); m++)
+			file << measures[m].Engine << " " << fixed << setprecision(0) << measures[m].Rate << " "
+				<< measures[m].Nodes << endl;
+
+		return file.good();
+	}
+
+	/**
+	 * Checks the speed of the engines against a baseline.
+	 * \arg		checker		record of the checks
+	 * \arg		measures	the speed of each engine
+	 * \arg		baseline	the speed each engine had
+	 * \arg		slower		fraction of the puzzles per second of the baseline which may be lost
+	 * \arg		nodes		fraction of the nodes of the baseline which may be added
+	 * \arg		timed		whether the puzzles per second are checked too, which only makes sense
+	 *						against a baseline of this machine; the nodes always are
+	 */
+	void TestBaseline::run(Checker& checker, const vector<Measure>& measures, const vector<Measure>& baseline,
+		double slower, double nodes, bool timed)
+	{
+		for(size_t b = 0; b < baseline.size(); b++) {
+			const Measure& before = baseline[b];
+			size_t m = 0;
+
+			while(m < measures.size() && measures[m].Engine != before.Engine)
+				m++;
+
+			if(!SUDOKU_CHECK(checker, m < measures.size(), "no engine " + before.Engine + " to measure"))
+				continue;
+
+			const Measure& after = measures[m];
+
+			cout << "baseline: " << setw(10) << left << after.Engine << right << fixed << setprecision(0)
+				<< after.Rate << " puzzles/s (" << before.Rate << " before), " << after.Nodes << " nodes ("
+				<< before.Nodes << " before)" << endl;
+
+			if(timed)
+				SUDOKU_CHECK(checker, after.Rate >= before.Rate * (1 - slower), after.Engine + ": fewer puzzles per second");
+			SUDOKU_CHECK(checker, after.Nodes <= before.Nodes * (1 + nodes), after.Engine + ": more nodes");
+		}
+	}
+}
+}
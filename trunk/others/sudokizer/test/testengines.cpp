@@ -0,0 +1,494 @@
+// See COPYING file for licensing information.
+/**
+ * \file testengines.cpp
+ * Differential tests of the engines.
+ */
+
+#include "testsudoku.h"
+#include "search.h"
+#include "backjump.h"
+#include "sat.h"
+#include "portfolio.h"
+#include "batch.h"
+#include "symmetry.h"
+#include "validator.h"
+#include "variant.h"
+#include "libsudoku.h"
+#include <iostream>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Visitor of the SAT enumeration which only lets it count.
+	 */
+	static bool skip(const Grid&, void*) {
+		return true;
+	}
+
+	/**
+	 * Writes the cells of a grid as characters, '.' for the empty ones.
+	 */
+	static void text(const Grid& grid, char* out) {
+		for(short unsigned int c = 0; c < 81; c++)
+			out[c] = grid.get(c) != 0 ? '0' + grid.get(c) : '.';
+	}
+
+	/**
+	 * Checks the result of an engine against the reference.
+	 * \arg		checker		record of the checks
+	 * \arg		engine		name of the engine
+	 * \arg		puzzle		the puzzle, as characters
+	 * \arg		solved		whether the engine found a solution
+	 * \arg		found		the solution it found, as characters
+	 * \arg		solutions	number of solutions of the puzzle, up to the limit of the counts
+	 * \arg		reference	the solution of the reference search, as characters
+	 */
+	static void compare(Checker& checker, const string& engine, const char* puzzle, bool solved, const char* found,
+		unsigned long solutions, const char* reference)
+	{
+		string name = engine + " on " + string(puzzle, 81);
+		bool kept = true;
+
+		if(!SUDOKU_CHECK(checker, solved == (solutions != 0), name + (solved ? ": solved" : ": not solved")) || !solved)
+			return;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			kept = kept && (puzzle[c] == '.' || found[c] == puzzle[c]);
+
+		SUDOKU_CHECK(checker, Validator::check(found) && kept, name + ": wrong solution " + string(found, 81));
+		if(solutions == 1)
+			SUDOKU_CHECK(checker, memcmp(found, reference, 81) == 0, name + ": not the single solution");
+	}
+
+	/**
+	 * Extra rules of a variant, which the test keeps on its own to check the solutions of Variant
+	 * without its code.
+	 */
+	typedef struct {
+		vector< vector<unsigned char> > Units;
+		vector<Cage> Cages;
+		unsigned long Obeying;	// solutions of the classic search which keep the rules
+	} Rules;
+
+	/**
+	 * Tells whether a solved grid keeps extra rules: every unit holds the values 1 to 9, and the
+	 * cells of every cage hold different values adding up to its sum.
+	 */
+	static bool obeys(const Grid& grid, const Rules& rules) {
+		for(size_t u = 0; u < rules.Units.size(); u++) {
+			short unsigned int seen = 0;
+
+			for(short unsigned int i = 0; i < 9; i++)
+				seen |= 1 << (grid.get(rules.Units[u][i]) - 1);
+			if(seen != 0x1FF)
+				return false;
+		}
+
+		for(size_t k = 0; k < rules.Cages.size(); k++) {
+			short unsigned int seen = 0, sum = 0;
+
+			for(size_t i = 0; i < rules.Cages[k].Cells.size(); i++) {
+				short unsigned int value = grid.get(rules.Cages[k].Cells[i]);
+
+				if(seen & (1 << value))
+					return false;
+				seen |= 1 << value;
+				sum += value;
+			}
+			if(sum != rules.Cages[k].Sum)
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Visitor of the classic enumeration counting the solutions which keep extra rules.
+	 */
+	static bool filter(const Grid& grid, void* rules) {
+		Rules& Kept = *static_cast<Rules*>(rules);
+
+		if(obeys(grid, Kept))
+			Kept.Obeying++;
+		return true;
+	}
+
+	/**
+	 * Builds a random puzzle: random givens are added as long as the puzzle keeps a solution. One
+	 * of every four puzzles then gets the values of one of its solutions, one cell at a time, till
+	 * another value of a cell leaves it with none without the propagation finding it out; that
+	 * value is its last given. Most of them get filled up before.
+	 * \arg		values	set to the 81 cells of the puzzle, 0 for the empty ones
+	 * \arg		index	number of the puzzle, which gives its number of givens
+	 * \arg		seed	state of the random numbers
+	 */
+	void TestEngines::random(short unsigned int* values, unsigned long index, unsigned int& seed) {
+		Grid grid;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			values[c] = 0;
+
+		for(short unsigned int i = 0; i < 17 + index % 14; i++) {
+			short unsigned int c = rand_r(&seed) % 81, value = rand_r(&seed) % 9 + 1;
+			Grid next = grid;
+
+			if(values[c] == 0 && next.assign(c, value) && Search::count(next, 1) != 0) {
+				grid = next;
+				values[c] = value;
+			}
+		}
+
+		// Givens of a solution are added till another value of some cell leaves none
+		Grid solved = grid;
+
+		if(index % 4 != 3 || !Search::solve(solved))
+			return;
+
+		while(!grid.isSolved()) {
+			short unsigned int c = rand_r(&seed) % 81;
+
+			while(grid.get(c) != 0)
+				c = (c + 1) % 81;
+
+			for(short unsigned int value = 1; value <= 9; value++) {
+				Grid next = grid;
+
+				if(value != solved.get(c) && next.assign(c, value) && Search::count(next, 1) == 0) {
+					values[c] = value;
+					return;
+				}
+			}
+
+			grid.assign(c, solved.get(c));
+			values[c] = solved.get(c);
+		}
+	}
+
+	/**
+	 * Solves and counts a puzzle with every engine, and checks that they agree.
+	 * \arg		checker		record of the checks
+	 * \arg		values		the 81 cells of the puzzle, 0 for the empty ones
+	 * \arg		unique		whether the puzzle is known to have a single solution
+	 * \arg		seed		state of the random numbers
+	 * \arg		solution	set to the solution of the reference search as characters, or to the
+	 *						puzzle if it has none
+	 * \return	number of solutions of the puzzle, up to Limit
+	 */
+	unsigned long TestEngines::differ(Checker& checker, const short unsigned int* values, bool unique,
+		unsigned int& seed, char* solution)
+	{
+		char puzzle[81], found[81];
+		string name;
+		Grid grid;
+		bool valid = true;
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			puzzle[c] = values[c] != 0 ? '0' + values[c] : '.';
+			if(values[c] != 0 && valid)
+				valid = grid.assign(c, values[c]);
+		}
+
+		name = string(puzzle, 81);
+		memcpy(solution, puzzle, 81);
+		if(!SUDOKU_CHECK(checker, valid, "givens contradicting each other in " + name))
+			return 0;
+
+		// The single-threaded search is the reference the others are compared with
+		Grid reference = grid;
+		unsigned long solutions = Search::count(grid, Limit);
+		bool solved = Search::solve(reference);
+
+		if(solved)
+			text(reference, solution);
+		compare(checker, "search", puzzle, solved, solution, solutions, solution);
+		if(unique)
+			SUDOKU_CHECK(checker, solutions == 1, "no single solution for " + name);
+
+		// The counts
+		{
+			TranspositionTable table(1 << 16);
+			Budget budget;
+
+			SUDOKU_CHECK(checker, Search::count(grid, Limit, 2) == solutions, "threaded count of " + name);
+			SUDOKU_CHECK(checker, Search::count(grid, table, Limit) == solutions, "count with a table of " + name);
+			SUDOKU_CHECK(checker, SatSolver::enumerate(grid, skip, 0, budget, Limit) == solutions, "SAT count of " + name);
+			SUDOKU_CHECK(checker, sudoku_count(puzzle, Limit) == solutions, "C count of " + name);
+			SUDOKU_CHECK(checker, Variant().count(values, Limit) == solutions, "count of a plain variant of " + name);
+
+			unsigned long counted;
+			int result = sudoku_count_opts(puzzle, Limit, 0, &counted);
+
+			SUDOKU_CHECK(checker, counted == solutions && result == (solutions == 0 ? SUDOKU_UNSOLVABLE :
+				solutions == 1 ? SUDOKU_SOLVED : SUDOKU_MULTIPLE), "C count with options of " + name);
+		}
+
+		// The solutions of every engine
+		{
+			Grid threaded = grid, tabled = grid, backjumped = grid;
+			TranspositionTable table(1 << 16);
+
+			solved = Search::solve(threaded, 2);
+			text(threaded, found);
+			compare(checker, "threaded search", puzzle, solved, found, solutions, solution);
+
+			solved = Search::solve(tabled, table);
+			text(tabled, found);
+			compare(checker, "search with a table", puzzle, solved, found, solutions, solution);
+
+			solved = Backjumper::solve(backjumped);
+			text(backjumped, found);
+			compare(checker, "backjump", puzzle, solved, found, solutions, solution);
+		}
+
+		{
+			Board Sudoku;
+			Grid loaded;
+
+			grid.store(Sudoku);
+			solved = SatSolver::solve(Sudoku) && loaded.load(Sudoku);
+			text(loaded, found);
+			compare(checker, "sat", puzzle, solved, found, solutions, solution);
+		}
+
+		{
+			Board Sudoku;
+			Portfolio portfolio;
+			Grid loaded;
+
+			grid.store(Sudoku);
+			solved = portfolio.solve(Sudoku) && loaded.load(Sudoku);
+			text(loaded, found);
+			compare(checker, "portfolio", puzzle, solved, found, solutions, solution);
+		}
+
+		{
+			Variant variant;
+			short unsigned int cells[81];
+
+			memcpy(cells, values, sizeof(cells));
+			solved = variant.solve(cells);
+			for(short unsigned int c = 0; c < 81; c++)
+				found[c] = '0' + cells[c];
+			compare(checker, "plain variant", puzzle, solved, found, solutions, solution);
+		}
+
+		solved = sudoku_solve(puzzle, found, 0) == SUDOKU_SOLVED;
+		compare(checker, "C interface", puzzle, solved, found, solutions, solution);
+
+		variant(checker, values, grid, solutions, solution, seed);
+
+		// The logic solver only has to be right when it finishes
+		{
+			Board Sudoku;
+			Budget budget;
+			Grid loaded;
+
+			grid.store(Sudoku);
+			try {
+				if(Solver::resolve(Sudoku, budget) && Sudoku.getState() == definitive) {
+					solved = loaded.load(Sudoku);
+					text(loaded, found);
+					compare(checker, "logic", puzzle, solved, found, solutions, solution);
+				}
+			} catch(logic_error&) {
+				SUDOKU_CHECK(checker, solutions == 0, "logic: no solution found for " + name);
+			}
+		}
+
+		// An equivalent puzzle has the equivalent solution
+		if(solutions == 1) {
+			Transform transform;
+			char moved[81], expected[81];
+			unsigned long long index = static_cast<unsigned long long>(rand_r(&seed)) << 31 | rand_r(&seed);
+			Grid equivalent;
+
+			Symmetry::build(index % Symmetry::Transforms, transform);
+			Symmetry::apply(transform, puzzle, moved);
+			Symmetry::apply(transform, solution, expected);
+
+			for(short unsigned int c = 0; c < 81 && valid; c++)
+				if(moved[c] != '.')
+					valid = equivalent.assign(c, moved[c] - '0');
+
+			solved = valid && Search::solve(equivalent);
+			text(equivalent, found);
+			compare(checker, "search after a symmetry", moved, solved, found, 1, expected);
+		}
+
+		return solutions;
+	}
+
+	/**
+	 * Solves and counts a puzzle with Variant under random extra rules: the diagonals, the
+	 * windows, or killer cages, whose sums are the ones of the solution if there's one. The classic
+	 * solutions which keep the rules, by the check of the test, have to be the ones of Variant.
+	 * \arg		checker		record of the checks
+	 * \arg		values		the 81 cells of the puzzle, 0 for the empty ones
+	 * \arg		grid		the givens of the puzzle
+	 * \arg		solutions	number of classic solutions of the puzzle, up to Limit
+	 * \arg		solution	a classic solution as characters, or the puzzle if it has none
+	 * \arg		seed		state of the random numbers
+	 */
+	void TestEngines::variant(Checker& checker, const short unsigned int* values, const Grid& grid,
+		unsigned long solutions, const char* solution, unsigned int& seed)
+	{
+		static const char* names[] = {"X-sudoku", "windoku", "killer", "killer X-sudoku"};
+		short unsigned int kind = rand_r(&seed) % 4, taken[81] = {0};
+		string name = string(names[kind]) + " of " + string(solution, 81);
+		Variant rules;
+		Rules kept;
+
+		kept.Obeying = 0;
+		if(kind == 0 || kind == 3)
+			for(short unsigned int d = 0; d < 2; d++) {
+				vector<unsigned char> diagonal;
+
+				for(short unsigned int i = 0; i < 9; i++)
+					diagonal.push_back(d == 0 ? i * 9 + i : i * 9 + 8 - i);
+				kept.Units.push_back(diagonal);
+			}
+		if(kind == 1)
+			for(short unsigned int w = 0; w < 4; w++) {
+				vector<unsigned char> window;
+
+				for(short unsigned int r = 1 + w / 2 * 4; r < 4 + w / 2 * 4; r++)
+					for(short unsigned int c = 1 + w % 2 * 4; c < 4 + w % 2 * 4; c++)
+						window.push_back(r * 9 + c);
+				kept.Units.push_back(window);
+			}
+		if(kind >= 2)
+			for(short unsigned int k = 0; k < 6; k++) {
+				Cage cage;
+				short unsigned int cell = rand_r(&seed) % 81, size = 2 + rand_r(&seed) % 3;
+
+				// A path of cells from a random one, each one right of or below the previous one, which
+				// no other cage took: so a cage spans several rows, columns and boxes
+				while(cage.Cells.size() < size && cell < 81 && !taken[cell]) {
+					cage.Cells.push_back(cell);
+					taken[cell] = 1;
+					cell += (cell % 9 == 8 || rand_r(&seed) % 2) ? 9 : 1;
+				}
+
+				cage.Sum = 0;
+				for(size_t i = 0; i < cage.Cells.size(); i++)
+					cage.Sum += solution[cage.Cells[i]] != '.' ? solution[cage.Cells[i]] - '0' : 1 + rand_r(&seed) % 9;
+				if(cage.Cells.size() >= 2 && Variant::cageOptions(cage.Cells.size(), cage.Sum, 0x1FF) != 0)
+					kept.Cages.push_back(cage);
+			}
+
+		for(size_t u = 0; u < kept.Units.size(); u++)
+			rules.addUnit(&kept.Units[u][0]);
+		for(size_t k = 0; k < kept.Cages.size(); k++)
+			SUDOKU_CHECK(checker, rules.addCage(&kept.Cages[k].Cells[0], kept.Cages[k].Cells.size(), kept.Cages[k].Sum),
+				name + ": cage refused");
+
+		// All the classic solutions are enumerated below Limit; past it, Variant finds at least
+		// the ones which keep the rules among them
+		unsigned long found = rules.count(values, Limit);
+
+		Search::enumerate(grid, filter, &kept, Limit);
+		SUDOKU_CHECK(checker, solutions < Limit ? found == kept.Obeying : found >= kept.Obeying, name + ": count");
+
+		short unsigned int cells[81];
+		char text[81];
+		bool solved, right = true;
+
+		memcpy(cells, values, sizeof(cells));
+		solved = rules.solve(cells);
+		if(!SUDOKU_CHECK(checker, solved == (found != 0), name + (solved ? ": solved" : ": not solved")) || !solved)
+			return;
+
+		Grid loaded;
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			text[c] = '0' + cells[c];
+			right = right && (values[c] == 0 || cells[c] == values[c]) && loaded.assign(c, cells[c]);
+		}
+		SUDOKU_CHECK(checker, right && Validator::check(text) && obeys(loaded, kept), name + ": wrong solution " +
+			string(text, 81));
+	}
+
+	/**
+	 * Runs the differential tests.
+	 * \arg		checker	record of the checks
+	 * \arg		corpus	the 81 cells of the puzzles of the corpus, which have a single solution
+	 * \arg		count	number of random puzzles checked after the ones of the corpus
+	 * \arg		seed	seed of the random puzzles
+	 */
+	void TestEngines::run(Checker& checker, const vector<short unsigned int>& corpus, unsigned long count,
+		unsigned int seed)
+	{
+		size_t total = corpus.size() / 81 + count;
+		vector<short unsigned int> puzzles(corpus);
+		vector<char> lines(total * 82), solutions(total * 81), solved(total * 82);
+		vector<unsigned long> counts(total);
+
+		puzzles.resize(total * 81);
+		for(size_t p = corpus.size() / 81; p < total; p++)
+			random(&puzzles[p * 81], p, seed);
+
+		for(size_t p = 0; p < total; p++) {
+			counts[p] = differ(checker, &puzzles[p * 81], p < corpus.size() / 81, seed, &solutions[p * 81]);
+
+			for(short unsigned int c = 0; c < 81; c++)
+				lines[p * 82 + c] = puzzles[p * 81 + c] != 0 ? '0' + puzzles[p * 81 + c] : '.';
+			lines[p * 82 + 81] = '\n';
+		}
+
+		// The batch solves all of them at once, and copies the ones without solution
+		Batch batch;
+		size_t found = 0;
+
+		batch.solve(&lines[0], total, &solved[0]);
+		for(size_t p = 0; p < total; p++) {
+			const char* line = &solved[p * 82];
+
+			if(counts[p] == 0) {
+				SUDOKU_CHECK(checker, memcmp(line, &lines[p * 82], 81) == 0, "batch on " + string(&lines[p * 82], 81)
+					+ ": not copied");
+				continue;
+			}
+
+			found++;
+			compare(checker, "batch", &lines[p * 82], memchr(line, '.', 81) == 0, line, counts[p], &solutions[p * 81]);
+		}
+
+		// The Validator checks the solutions in bulk, each one followed by a copy with a cell changed
+		// or two cells swapped, and has to agree with the check of a single grid
+		vector<char> grids;
+
+		for(size_t p = 0; p < total; p++) {
+			if(counts[p] == 0)
+				continue;
+
+			grids.insert(grids.end(), &solved[p * 82], &solved[p * 82] + 82);
+			grids.insert(grids.end(), &solved[p * 82], &solved[p * 82] + 82);
+
+			char* copy = &grids[grids.size() - 82];
+			short unsigned int c = rand_r(&seed) % 81, other = rand_r(&seed) % 81;
+
+			if(rand_r(&seed) % 2)
+				copy[c] = "0123456789:x\x80"[rand_r(&seed) % 13];
+			else
+				swap(copy[c], copy[other]);
+		}
+
+		size_t checked = grids.size() / 82, valid = 0;
+		bool* bulk = new bool[checked];
+		bool agree = Validator::check(grids.empty() ? "" : &grids[0], checked, bulk, 82) <= checked;
+
+		for(size_t g = 0; g < checked; g++) {
+			agree = agree && bulk[g] == Validator::check(&grids[g * 82]) && (g % 2 == 1 || bulk[g]);
+			valid += bulk[g];
+		}
+		SUDOKU_CHECK(checker, agree && Validator::check(grids.empty() ? "" : &grids[0], checked, bulk, 82) == valid,
+			"validator in bulk");
+		delete[] bulk;
+
+		cout << "engines: " << found << " puzzles solved, " << total - found << " without solution" << endl;
+	}
+}
+}
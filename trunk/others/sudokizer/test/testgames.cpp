@@ -0,0 +1,394 @@
+// See COPYING file for licensing information.
+/**
+ * \file testgames.cpp
+ * Tests of the engines behind the games: the Hinter, the Reducer, the Carver and the Pool.
+ */
+
+#include "testsudoku.h"
+#include "hint.h"
+#include "reducer.h"
+#include "carver.h"
+#include "pool.h"
+#include "validator.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+
+namespace std {
+namespace sudoku {
+	/**
+	 * Builds a board holding the givens of a puzzle, with the possibilities they leave.
+	 */
+	static void build(const short unsigned int* values, Board& Sudoku) {
+		for(short unsigned int c = 0; c < 81; c++)
+			if(values[c] != 0)
+				Sudoku.setCell(c / 9, c % 9, values[c]);
+	}
+
+	/**
+	 * Solves a puzzle with the search.
+	 * \arg		values		the 81 cells, 0 for the empty ones
+	 * \arg		solution	set to the 81 values of a solution
+	 * \return	the number of solutions, up to 2
+	 */
+	static unsigned long solve(const short unsigned int* values, short unsigned int* solution) {
+		Grid grid;
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(values[c] != 0 && !grid.assign(c, values[c]))
+				return 0;
+
+		unsigned long solutions = Search::count(grid, 2);
+
+		if(solutions != 0 && Search::solve(grid))
+			for(short unsigned int c = 0; c < 81; c++)
+				solution[c] = grid.get(c);
+
+		return solutions;
+	}
+
+	/**
+	 * Tells whether a puzzle has a single solution, the given one, and only clues of another puzzle.
+	 * \arg		values		the 81 cells, 0 for the empty ones
+	 * \arg		solution	the 81 values of the expected solution
+	 * \arg		original	the clues which may be kept, 0 for the others
+	 */
+	static bool keeps(const short unsigned int* values, const short unsigned int* solution,
+		const short unsigned int* original)
+	{
+		short unsigned int found[81];
+
+		for(short unsigned int c = 0; c < 81; c++)
+			if(values[c] != 0 && values[c] != original[c])
+				return false;
+
+		return solve(values, found) == 1 && memcmp(found, solution, sizeof(found)) == 0;
+	}
+
+	/**
+	 * Tells whether every clue of a puzzle with a single solution is needed for it to stay single.
+	 */
+	static bool minimal(const short unsigned int* values) {
+		short unsigned int without[81], solution[81];
+
+		memcpy(without, values, sizeof(without));
+		for(short unsigned int c = 0; c < 81; c++) {
+			if(values[c] == 0)
+				continue;
+
+			without[c] = 0;
+			if(solve(without, solution) != 2)
+				return false;
+			without[c] = values[c];
+		}
+
+		return true;
+	}
+
+	/**
+	 * Tells whether two hints are the same step.
+	 */
+	static bool same(const Hint& a, const Hint& b) {
+		if(a.Technique != b.Technique || a.Place != b.Place || a.Value != b.Value || a.TargetCount != b.TargetCount)
+			return false;
+
+		for(short unsigned int t = 0; t < a.TargetCount; t++)
+			if(a.Targets[t] != b.Targets[t])
+				return false;
+
+		return true;
+	}
+
+	/**
+	 * Tells whether a hint is right: it places the value of the solution, or removes a value which
+	 * none of its targets has in the solution.
+	 */
+	static bool right(const Hint& hint, const short unsigned int* solution) {
+		if(hint.Technique == noHint || hint.TargetCount == 0)
+			return false;
+
+		for(short unsigned int t = 0; t < hint.TargetCount; t++)
+			if((solution[hint.Targets[t]] == hint.Value) != hint.Place)
+				return false;
+
+		return true;
+	}
+
+	/**
+	 * Tests the Hinter over the first puzzles of the corpus.
+	 * \arg		checker	record of the checks
+	 * \arg		corpus	the 81 cells of the puzzles, which have a single solution
+	 */
+	void TestGames::hinter(Checker& checker, const vector<short unsigned int>& corpus) {
+		size_t count = corpus.size() / 81 < 20 ? corpus.size() / 81 : 20;
+		Hinter reused;
+
+		for(size_t p = 0; p < count; p++) {
+			const short unsigned int* values = &corpus[p * 81];
+			short unsigned int solution[81];
+			string name = "hints on puzzle " + to_string(p + 1) + " of the corpus";
+			Board Sudoku;
+
+			solve(values, solution);
+			build(values, Sudoku);
+
+			// Each hint is right, and the moves of the game are followed without rebuilding: till a
+			// removal is remembered, a new Hinter gives the same hints
+			Hinter hinter;
+			bool correct = true, removed = false;
+
+			for(short unsigned int moves = 0; moves < 10 && correct; moves++) {
+				Hint hint = hinter.next(Sudoku);
+
+				if(hint.Technique == noHint)
+					break;
+				correct = right(hint, solution) && (removed || same(hint, Hinter().next(Sudoku)));
+				if(correct && hint.Place)
+					correct = Sudoku.place(hint.Targets[0] / 9, hint.Targets[0] % 9, hint.Value);
+				removed = removed || !hint.Place;
+			}
+			SUDOKU_CHECK(checker, correct, name + ": wrong hint");
+
+			// The grade of a Board and of its values agree, and a graded Board is solved
+			Board graded;
+			Hinter grader;
+
+			build(values, graded);
+			tTechnique grade = grader.grade(graded);
+
+			SUDOKU_CHECK(checker, grade == Hinter().grade(values), name + ": grades of the board and the values differ");
+			if(grade != noHint) {
+				bool solved = graded.getState() == definitive;
+
+				for(short unsigned int c = 0; c < 81 && solved; c++)
+					solved = graded.fastGetCell(c / 9, c % 9).get() == solution[c];
+				SUDOKU_CHECK(checker, solved, name + ": graded board not solved");
+			}
+
+			// The solver leaves the board as the moves do: a Hinter kept on it gives the hints of the
+			// resolved board, and a cell it filled can be erased and placed again
+			Board resolved;
+			Hinter kept;
+
+			build(values, resolved);
+			kept.next(resolved);
+			Solver::resolve(resolved);
+			SUDOKU_CHECK(checker, same(kept.next(resolved), Hinter().next(resolved)), name + ": hint after resolving");
+			for(short unsigned int c = 0; c < 81; c++)
+				if(values[c] == 0 && resolved.fastGetCell(c / 9, c % 9).getState() == definitive) {
+					resolved.erase(c / 9, c % 9);
+					SUDOKU_CHECK(checker, resolved.canPlace(c / 9, c % 9, solution[c]),
+						name + ": erased cell of the solver");
+					break;
+				}
+
+			// A Hinter kept from one game to the next, on a board assigned the new puzzle at the
+			// same address, gives the hints of the new puzzle
+			Board next, game;
+
+			build(&corpus[((p + 1) % count) * 81], next);
+			build(values, game);
+			reused.next(game);
+			game = next;
+			SUDOKU_CHECK(checker, same(reused.next(game), Hinter().next(game)), name + ": hint of the previous board");
+		}
+	}
+
+	/**
+	 * Tests the Reducer over the first puzzles of the corpus.
+	 * \arg		checker	record of the checks
+	 * \arg		corpus	the 81 cells of the puzzles, which have a single solution
+	 */
+	void TestGames::reducer(Checker& checker, const vector<short unsigned int>& corpus) {
+		size_t count = corpus.size() / 81 < 5 ? corpus.size() / 81 : 5;
+
+		for(size_t p = 0; p < count; p++) {
+			const short unsigned int* values = &corpus[p * 81];
+			short unsigned int reduced[81], solution[81];
+			string name = "reduction of puzzle " + to_string(p + 1) + " of the corpus";
+			short unsigned int clues;
+
+			solve(values, solution);
+
+			memcpy(reduced, values, sizeof(reduced));
+			clues = Reducer::reduce(reduced, p % 2 + 1);
+			SUDOKU_CHECK(checker, clues != 0 && keeps(reduced, solution, values) && minimal(reduced),
+				name + ": not minimal or another solution");
+
+			// The clues removed before the budget runs out still leave the same solution
+			bool kept = true;
+
+			for(unsigned long nodes = 1; nodes <= 1024 && kept; nodes *= 4) {
+				Budget budget(0, nodes);
+
+				memcpy(reduced, values, sizeof(reduced));
+				clues = Reducer::reduce(reduced, budget);
+				if(clues == 0)
+					kept = memcmp(reduced, values, sizeof(reduced)) == 0;
+				else
+					kept = keeps(reduced, solution, values);
+			}
+			SUDOKU_CHECK(checker, kept, name + ": budget exceeded leaving another puzzle");
+
+			volatile int cancel = 1;
+			Budget cancelled(0, 0, &cancel);
+
+			memcpy(reduced, values, sizeof(reduced));
+			SUDOKU_CHECK(checker, Reducer::reduce(reduced, cancelled) == 0 && memcmp(reduced, values, sizeof(reduced)) == 0,
+				name + ": cancelled reduction changed the puzzle");
+		}
+
+		// A puzzle without a single solution is left as it is
+		short unsigned int empty[81] = {0};
+		Board Sudoku;
+
+		SUDOKU_CHECK(checker, Reducer::reduce(empty) == 0 && Reducer::reduce(Sudoku) == 0, "reduction of an empty grid");
+	}
+
+	/**
+	 * Tests the Carver on the bands of the easy, medium and hard tiers of the Pool.
+	 * \arg		checker	record of the checks
+	 * \arg		seed	state of the random numbers
+	 */
+	void TestGames::carver(Checker& checker, unsigned int& seed) {
+		static const tTechnique bands[][2] = {{nakedSingle, hiddenSingle}, {lockedCandidates, lockedCandidates},
+			{nakedPair, xWing}};
+		static const char* names[] = {"easy", "medium", "hard"};
+
+		for(short unsigned int b = 0; b < 3; b++) {
+			Carver carver;
+			Budget budget(30);
+			string name = string("carving of a ") + names[b] + " puzzle";
+
+			if(!SUDOKU_CHECK(checker, carver.generate(bands[b][0], bands[b][1], seed, budget), name + ": none in 30 s"))
+				continue;
+
+			const short unsigned int* puzzle = carver.getPuzzle();
+			tTechnique grade = Hinter().grade(puzzle);
+
+			SUDOKU_CHECK(checker, grade == carver.getGrade() && grade >= bands[b][0] && grade <= bands[b][1],
+				name + ": grade out of the band");
+			SUDOKU_CHECK(checker, keeps(puzzle, carver.getSolution(), carver.getSolution()),
+				name + ": not the single solution");
+		}
+
+		Carver carver;
+		volatile int cancel = 1;
+		Budget cancelled(0, 0, &cancel);
+
+		SUDOKU_CHECK(checker, !carver.generate(nakedSingle, noHint, seed, cancelled), "carving within a cancelled budget");
+	}
+
+	/**
+	 * Tells whether an entry of the pool is a puzzle with its single solution.
+	 */
+	static bool valid(const Entry& entry) {
+		short unsigned int values[81], expected[81];
+
+		for(short unsigned int c = 0; c < 81; c++) {
+			values[c] = entry.Puzzle[c] == '.' ? 0 : entry.Puzzle[c] - '0';
+			expected[c] = entry.Solution[c] - '0';
+		}
+
+		return Validator::check(entry.Solution) && keeps(values, expected, expected);
+	}
+
+	/**
+	 * Tests the Ring and the Pool: the order and the bounds of the queues, the saving and loading
+	 * of the puzzles, and the puzzles the threads generate.
+	 * \arg		checker	record of the checks
+	 */
+	void TestGames::pool(Checker& checker) {
+		{
+			Ring ring(5);
+			Entry entry;
+			bool ordered = true;
+
+			for(short unsigned int i = 0; i < 8; i++) {
+				entry.Puzzle[0] = 'a' + i;
+				ordered = ordered && ring.push(entry);
+			}
+			SUDOKU_CHECK(checker, ring.capacity() == 8 && ring.size() == 8 && ordered && !ring.push(entry),
+				"ring filled up to its capacity, a power of two");
+
+			// Peeking at a full ring leaves it full
+			Entry entries[8];
+
+			ordered = ordered && ring.peek(entries, 8) == 8 && ring.size() == 8;
+			for(short unsigned int i = 0; i < 8 && ordered; i++)
+				ordered = entries[i].Puzzle[0] == 'a' + i;
+			SUDOKU_CHECK(checker, ordered && ring.peek(entries, 3) == 3 && ring.size() == 8, "ring peeked at in order");
+
+			for(short unsigned int i = 0; i < 8 && ordered; i++)
+				ordered = ring.pop(entry) && entry.Puzzle[0] == 'a' + i;
+			SUDOKU_CHECK(checker, ordered && ring.size() == 0 && !ring.pop(entry), "ring emptied in order");
+		}
+
+		Pool pool(8);
+		Entry entry;
+
+		for(short unsigned int t = 0; t < 4; t++)
+			pool.setWatermarks(static_cast<tDifficulty>(t), 0, 0);
+		pool.setWatermarks(easy, 2, 4);
+
+		// The threads fill the tier below its low watermark, and keep nothing for the others
+		bool filled = pool.start(1);
+
+		for(short unsigned int wait = 0; wait < 600 && filled && pool.size(easy) < 2; wait++)
+			usleep(100000);
+		pool.stop();
+
+		filled = filled && pool.size(easy) >= 2 && pool.size(easy) <= 4;
+		for(short unsigned int t = medium; t <= expert; t++)
+			filled = filled && pool.size(static_cast<tDifficulty>(t)) == 0;
+		if(!SUDOKU_CHECK(checker, filled, "pool tier filled by a thread"))
+			return;
+
+		bool generated = true;
+		unsigned long size = pool.size(easy);
+
+		for(unsigned long i = 0; i < size; i++) {
+			short unsigned int values[81];
+
+			generated = generated && pool.take(easy, entry) && valid(entry);
+			for(short unsigned int c = 0; c < 81; c++)
+				values[c] = entry.Puzzle[c] == '.' ? 0 : entry.Puzzle[c] - '0';
+			generated = generated && Hinter().grade(values) <= hiddenSingle && pool.put(easy, entry);
+		}
+		SUDOKU_CHECK(checker, generated, "pool puzzles easy and with a single solution");
+
+		// Saved and loaded back into another pool
+		char path[] = "/tmp/testsudoku-XXXXXX";
+		int fd = mkstemp(path);
+		Pool loaded(8);
+		bool same = fd >= 0 && pool.save(path) && pool.size(easy) == size && loaded.load(path) &&
+			loaded.size(easy) == size;
+
+		for(unsigned long i = 0; i < size && same; i++) {
+			Entry copy;
+
+			same = pool.take(easy, entry) && loaded.take(easy, copy) && memcmp(&entry, &copy, sizeof(entry)) == 0;
+		}
+		SUDOKU_CHECK(checker, same, "pool saved and loaded");
+
+		if(fd >= 0) {
+			close(fd);
+			unlink(path);
+		}
+	}
+
+	/**
+	 * Runs the tests of the engines of the games.
+	 * \arg		checker	record of the checks
+	 * \arg		corpus	the 81 cells of the puzzles of the corpus, which have a single solution
+	 * \arg		seed	seed of the random puzzles
+	 */
+	void TestGames::run(Checker& checker, const vector<short unsigned int>& corpus, unsigned int seed) {
+		hinter(checker, corpus);
+		reducer(checker, corpus);
+		carver(checker, seed);
+		pool(checker);
+	}
+}
+}
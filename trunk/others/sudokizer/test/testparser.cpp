@@ -0,0 +1,126 @@
+// See COPYING file for licensing information.
+/**
+ * \file testparser.cpp
+ * Tests of the reading of puzzles in each text format.
+ */
+
+#include "testsudoku.h"
+#include "parser.h"
+#include "render.h"
+#include <cstring>
+
+namespace std {
+namespace sudoku {
+	// The puzzles of the samples below, as lines of 81 cells
+	static const char first[] = "53..7....6..195....98....6.8...6...34..8.3..17...2...6.6....28....419..5....8..79";
+	static const char second[] = "..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82....26.95..8..2.3..9..5.1.3..";
+
+	/**
+	 * Tells whether the parser reads the two puzzles of a sample, and nothing else.
+	 * \arg		text	the sample
+	 * \arg		input	the format it has to be detected in
+	 * \arg		skipped	the lines which don't fit in the format
+	 */
+	static bool reads(const char* text, tInput input, unsigned long skipped) {
+		Parser parser(text, strlen(text));
+		short unsigned int values[81], expected[81];
+
+		if(parser.getInput() != input || Parser::detect(text, strlen(text)) != input)
+			return false;
+
+		for(short unsigned int p = 0; p < 2; p++)
+			if(!parser.next(values) || !Parser::parse(p == 0 ? first : second, expected)
+				|| memcmp(values, expected, sizeof(values)) != 0)
+				return false;
+
+		return !parser.next(values) && parser.getSkipped() == skipped;
+	}
+
+	/**
+	 * Runs the tests of the Parser class.
+	 * \arg		checker	record of the checks
+	 */
+	void TestParser::run(Checker& checker) {
+		{
+			string text = string("# two puzzles\n") + first + " a comment\r\n\n" + second + "\n";
+
+			SUDOKU_CHECK(checker, reads(text.c_str(), lineInput, 0), "lines of 81 cells");
+
+			text = string(first) + "\n" + string(first).substr(0, 80) + "\n" + second;
+			SUDOKU_CHECK(checker, reads(text.c_str(), lineInput, 1), "lines of 81 cells and a short one");
+		}
+
+		{
+			// As sudokizer shows them: the screen cleared, then the grid with its coordinates
+			string text = "\033[2J";
+			char buffer[1024];
+
+			for(short unsigned int p = 0; p < 2; p++) {
+				Board Sudoku;
+				short unsigned int values[81];
+
+				Parser::parse(p == 0 ? first : second, values);
+				for(short unsigned int c = 0; c < 81; c++)
+					if(values[c] != 0)
+						Sudoku.setCell(c / 9, c % 9, values[c]);
+
+				text.append(buffer, Render::format(Sudoku, pretty, buffer, sizeof(buffer)));
+			}
+
+			SUDOKU_CHECK(checker, reads(text.c_str(), prettyInput, 0), "grids with their coordinates");
+		}
+
+		{
+			// A .sdk file of SadMan Sudoku, with its header
+			const char text[] =
+				"#AAuthor\n"
+				"#DTwo puzzles\n"
+				"[Puzzle]\n"
+				"53..7....\n" "6..195...\n" ".98....6.\n" "8...6...3\n" "4..8.3..1\n" "7...2...6\n" ".6....28.\n" "...419..5\n" "....8..79\n"
+				"\n"
+				"[Puzzle]\n"
+				"..3.2.6..\n" "9..3.5..1\n" "..18.64..\n" "..81.29..\n" "7.......8\n" "..67.82..\n" "..26.95..\n" "8..2.3..9\n" "..5.1.3..\n";
+
+			SUDOKU_CHECK(checker, reads(text, sdkInput, 0), "SadMan Sudoku file");
+		}
+
+		{
+			// A .ss file as Simple Sudoku saves it, framed by lines of '*' and '-'
+			const char text[] =
+				"*-----------*\n"
+				"|53.|.7.|...|\n" "|6..|195|...|\n" "|.98|...|.6.|\n"
+				"|---+---+---|\n"
+				"|8..|.6.|..3|\n" "|4..|8.3|..1|\n" "|7..|.2.|..6|\n"
+				"|---+---+---|\n"
+				"|.6.|...|28.|\n" "|...|419|..5|\n" "|...|.8.|.79|\n"
+				"*-----------*\n"
+				"\n"
+				"*-----------*\n"
+				"|..3|.2.|6..|\n" "|9..|3.5|..1|\n" "|..1|8.6|4..|\n"
+				"|---+---+---|\n"
+				"|..8|1.2|9..|\n" "|7..|...|..8|\n" "|..6|7.8|2..|\n"
+				"|---+---+---|\n"
+				"|..2|6.9|5..|\n" "|8..|2.3|..9|\n" "|..5|.1.|3..|\n"
+				"*-----------*\n";
+
+			SUDOKU_CHECK(checker, reads(text, ssInput, 0), "Simple Sudoku file");
+
+			// The same without the frame, and a broken row which drops the rows read before it
+			const char broken[] =
+				"|53.|.7.|...|\n" "|6..|195|...|\n" "|.98|...|.6.|\n" "|8..|.6.|..3|\n" "|4..|8.3|..1|\n"
+				"|7..|.2.|..6|\n" "|.6.|...|28.|\n" "|...|419|..5|\n" "|...|.8.|.79|\n"
+				"|..3|.2.|6..|\n" "|9..|3.5|..x|\n"
+				"|..3|.2.|6..|\n" "|9..|3.5|..1|\n" "|..1|8.6|4..|\n" "|..8|1.2|9..|\n" "|7..|...|..8|\n"
+				"|..6|7.8|2..|\n" "|..2|6.9|5..|\n" "|8..|2.3|..9|\n" "|..5|.1.|3..|\n";
+
+			SUDOKU_CHECK(checker, reads(broken, ssInput, 2), "Simple Sudoku rows with a broken one");
+		}
+
+		{
+			const char text[] = "# nothing\nthis is no sudoku\n";
+
+			SUDOKU_CHECK(checker, Parser::detect(text, sizeof(text) - 1) == unknownInput, "unknown format");
+		}
+	}
+}
+}
@@ -1,37 +1,278 @@
 // See COPYING file for licensing information.
 /**
  * \file testsudoku.cpp
- * Tests for the classes inside src/sudoku.cpp
+ * Tests of the Cell class, and entry point of the tests.
  */
 
 #include "testsudoku.h"
-#include "../src/sudoku.cpp"
+#include "sudoku.h"
+#include "parser.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
 
 using namespace std;
 using namespace sudoku;
 
-void TestCell::newDelete() {
+namespace std {
+namespace sudoku {
+	/**
+	 * Checker constructor.
+	 */
+	Checker::Checker()
+		: Checks(0), Failures(0)
 	{
-		Cell myCell(1); // constructor called here
-	} // destructor called here
-}
+	}
+
+	/**
+	 * Makes a check.
+	 * \arg		passed	result of the check
+	 * \arg		file	source file of the check
+	 * \arg		line	line of the check
+	 * \arg		what	what was checked, written if it failed
+	 * \return	passed
+	 */
+	bool Checker::check(bool passed, const char* file, int line, const string& what) {
+		Checks++;
+
+		if(!passed && ++Failures <= Shown) {
+			cerr << file << ":" << line << ": " << what << endl;
+			if(Failures == Shown)
+				cerr << "(the next failures are only counted)" << endl;
+		}
+
+		return passed;
+	}
+
+	/**
+	 * Returns the number of checks made.
+	 */
+	unsigned long Checker::getChecks() const {
+		return Checks;
+	}
+
+	/**
+	 * Returns the number of checks which failed.
+	 */
+	unsigned long Checker::getFailures() const {
+		return Failures;
+	}
+
+	/**
+	 * Tells whether the possibilities of a cell are the given ones, in order.
+	 */
+	static bool holds(Cell& cell, const char* expected) {
+		short unsigned int* possibilities = cell.getPossibilities();
+		short unsigned int i = 0;
+
+		for(; expected[i] != 0; i++)
+			if(possibilities[i] != static_cast<short unsigned int>(expected[i] - '0'))
+				return false;
+
+		return i == 9 || possibilities[i] == 0;
+	}
+
+	/**
+	 * Runs the tests of the Cell class.
+	 * \arg		checker	record of the checks
+	 */
+	void TestCell::run(Checker& checker) {
+		{
+			Cell cell;
+
+			SUDOKU_CHECK(checker, cell.getState() == undecided && holds(cell, "123456789"), "new cell");
+
+			// The list is full, so removing its last value mustn't read past it
+			cell.delPossibility(9);
+			SUDOKU_CHECK(checker, holds(cell, "12345678") && !cell.isPossible(9), "removal of the last value");
+
+			cell.delPossibility(1);
+			cell.delPossibility(5);
+			cell.delPossibility(5);
+			SUDOKU_CHECK(checker, holds(cell, "234678"), "removal of the first and middle values");
+
+			cell.addPossibility(5);
+			cell.addPossibility(5);
+			SUDOKU_CHECK(checker, holds(cell, "2346785") && cell.isPossible(5), "addition of a value");
+
+			cell.delPossibility(0);
+			cell.delPossibility(10);
+			SUDOKU_CHECK(checker, holds(cell, "2346785"), "removal of values out of range");
+		}
+
+		{
+			Cell cell;
+
+			for(short unsigned int p = 1; p < 9; p++)
+				cell.delPossibility(p);
+			SUDOKU_CHECK(checker, cell.getState() == definitive && cell.get() == 9, "single value left");
+
+			bool thrown = false;
+
+			try {
+				cell.delPossibility(9);
+			} catch(logic_error&) {
+				thrown = true;
+			}
+			SUDOKU_CHECK(checker, thrown, "removal of the only value left");
+		}
+
+		{
+			Cell cell, copy;
+			bool outOfRange = false, impossible = false, undecidedGet = false;
+
+			try {
+				cell.set(10);
+			} catch(domain_error&) {
+				outOfRange = true;
+			}
+
+			cell.delPossibility(4);
+			try {
+				cell.set(4);
+			} catch(domain_error&) {
+				impossible = true;
+			}
+
+			try {
+				cell.get();
+			} catch(logic_error&) {
+				undecidedGet = true;
+			}
+			SUDOKU_CHECK(checker, outOfRange && impossible && undecidedGet, "errors of set and get");
+
+			cell.set(7);
+			copy.copy(cell);
+			SUDOKU_CHECK(checker, copy.getState() == definitive && copy.get() == 7 && holds(copy, "7"), "set and copy");
 
+			copy.erase();
+			SUDOKU_CHECK(checker, copy.getState() == undecided && holds(copy, "123456789"), "erase");
+		}
 
-void TestCell::possibilities_data(QtTestTable &t) {
-	short unsigned int arr1[2] = {1, 2}, arr2[2] = {1, 2};
-	
-	t.defineElement("ushort", "e1");
-	t.defineElement("ushort", "e2");
-	
-    *t.newData("constructor with no args") <<  arr1[0] << arr2[0];
-    *t.newData("constructor with no args") <<  arr1[1] << arr2[1];
+		{
+			Cell cell(3, definitive);
+
+			SUDOKU_CHECK(checker, cell.get() == 3 && holds(cell, "3"), "cell built with a value");
+		}
+	}
+}
 }
 
-void TestCell::possibilities() {
-    FETCH(ushort, e1);
-    FETCH(ushort, e2);
-	
-	COMPARE(e1, e2);
+/**
+ * Prints the usage.
+ */
+static int usage(const char* name) {
+	cerr << "usage: " << name << " [-n random] [-s seed] [-t slower] [-m nodes] [-u] corpus baseline" << endl
+		<< "  corpus      puzzles with a single solution, in any format the command line reads" << endl
+		<< "  baseline    speeds of the engines to check, - to skip the timed checks" << endl
+		<< "  -n random   random puzzles checked besides the corpus (default: 2000)" << endl
+		<< "  -s seed     seed of the random puzzles (default: the time)" << endl
+		<< "  -t slower   fraction of the puzzles per second of the baseline which may be lost (default: 0.25)" << endl
+		<< "  -m nodes    fraction of the nodes of the baseline which may be added (default: 0.02)" << endl
+		<< "  -u          record the baseline instead of checking it" << endl;
+	return 2;
 }
 
-QTTEST_APPLESS_MAIN(TestCell);
+/**
+ * Tests entry point.
+ * \return	0 if every check passed, 1 if not, 2 for a usage error
+ */
+int main(int argc, char** argv) {
+	unsigned long count = 2000;
+	unsigned int seed = time(0);
+	double slower = 0.25, nodes = 0.02;
+	bool record = false;
+	int option;
+
+	while((option = getopt(argc, argv, "n:s:t:m:u")) != -1) {
+		switch(option) {
+			case 'n':
+				count = strtoul(optarg, 0, 10);
+				break;
+			case 's':
+				seed = strtoul(optarg, 0, 10);
+				break;
+			case 't':
+				slower = atof(optarg);
+				break;
+			case 'm':
+				nodes = atof(optarg);
+				break;
+			case 'u':
+				record = true;
+				break;
+			default:
+				return usage(argv[0]);
+		}
+	}
+
+	if(optind != argc - 2)
+		return usage(argv[0]);
+
+	const char* baselinePath = argv[optind + 1];
+	ifstream file(argv[optind]);
+
+	if(!file) {
+		cerr << argv[0] << ": can't read " << argv[optind] << endl;
+		return 2;
+	}
+
+	string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	vector<short unsigned int> corpus;
+	short unsigned int values[81];
+	Parser parser(text.data(), text.size());
+
+	while(parser.next(values))
+		corpus.insert(corpus.end(), values, values + 81);
+
+	if(corpus.empty()) {
+		cerr << argv[0] << ": no puzzle found in " << argv[optind] << endl;
+		return 2;
+	}
+
+	Checker checker;
+
+	TestCell::run(checker);
+	TestParser::run(checker);
+
+	// The seed is given so that a failure can be run again
+	cout << "engines: " << corpus.size() / 81 << " puzzles of the corpus and " << count
+		<< " random ones, seed " << seed << endl;
+	TestEngines::run(checker, corpus, count, seed);
+	TestVariant::run(checker);
+	TestGames::run(checker, corpus, seed);
+
+	if(strcmp(baselinePath, "-") != 0) {
+		vector<Measure> measures, baseline;
+		string host;
+
+		TestBaseline::measure(corpus, measures);
+
+		if(record) {
+			if(!TestBaseline::save(baselinePath, measures)) {
+				cerr << argv[0] << ": can't write " << baselinePath << endl;
+				return 2;
+			}
+			cout << "baseline recorded in " << baselinePath << endl;
+		} else if(!TestBaseline::load(baselinePath, baseline, host))
+			cout << "no baseline in " << baselinePath << ", the timed checks are skipped; -u records it" << endl;
+		else {
+			bool timed = host == TestBaseline::machine();
+
+			// The puzzles per second of another machine say nothing about this one
+			if(!timed)
+				cout << "baseline measured on " << (host.empty() ? "another machine" : host)
+					<< ", only the nodes are checked; -u records the one of this machine" << endl;
+			TestBaseline::run(checker, measures, baseline, slower, nodes, timed);
+		}
+	}
+
+	cout << checker.getChecks() << " checks, " << checker.getFailures() << " failed" << endl;
+
+	return checker.getFailures() == 0 ? 0 : 1;
+}
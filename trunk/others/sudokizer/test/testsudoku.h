@@ -1,24 +1,135 @@
 // See COPYING file for licensing information.
 /**
  * \file testsudoku.h
- * Definition of the tests for the classes inside src/sudoku.h
+ * Definition of the tests: the Cell class, the Parser, the engines checked against each other and
+ * against the Validator, the rules of the variants, the engines of the games, and the speed of
+ * the engines checked against a stored baseline.
  */
 
 #ifndef TESTSUDOKU_H
 #define TESTSUDOKU_H
 
-#include <QtTest>
-#include "../src/sudoku.h"
+#include <string>
+#include <vector>
+
+/**
+ * Makes a check, reported with the place it was made at if it fails.
+ */
+#define SUDOKU_CHECK(checker, passed, what) (checker).check((passed), __FILE__, __LINE__, (what))
 
 namespace std {
 namespace sudoku {
-	class TestCell: public QObject
-	{
-			Q_OBJECT
-		private slots:
-			void newDelete();
-			void possibilities_data(QtTestTable &t);
-			void possibilities();
+	class Grid;
+
+	/**
+	 * Record of the checks made by the tests. The first failures are written to the standard error,
+	 * the later ones are only counted.
+	 */
+	class Checker {
+		unsigned long Checks, Failures;
+
+		static const unsigned long Shown = 20;
+	public:
+		Checker();
+
+		bool check(bool passed, const char* file, int line, const string& what);
+		unsigned long getChecks() const;
+		unsigned long getFailures() const;
+	};
+
+	/**
+	 * Tests of the possibilities of a Cell.
+	 */
+	class TestCell {
+		TestCell();
+	public:
+		static void run(Checker& checker);
+	};
+
+	/**
+	 * Tests of the reading of puzzles in each text format, from samples of the programs which write
+	 * them.
+	 */
+	class TestParser {
+		TestParser();
+	public:
+		static void run(Checker& checker);
+	};
+
+	/**
+	 * Tests of the rules of the sudoku variants: the values a cage can hold, the cages refused, and
+	 * puzzles with cages, diagonals and windows solved within their rules.
+	 */
+	class TestVariant {
+		TestVariant();
+	public:
+		static void run(Checker& checker);
+	};
+
+	/**
+	 * Tests of the engines behind the games: the hints are right and follow the game, the reduced
+	 * puzzles are minimal with the same solution, the carved puzzles are in their band, and the
+	 * pool keeps its puzzles in order and fills its tiers.
+	 */
+	class TestGames {
+		TestGames();
+
+		static void hinter(Checker& checker, const vector<short unsigned int>& corpus);
+		static void reducer(Checker& checker, const vector<short unsigned int>& corpus);
+		static void carver(Checker& checker, unsigned int& seed);
+		static void pool(Checker& checker);
+	public:
+		static void run(Checker& checker, const vector<short unsigned int>& corpus, unsigned int seed);
+	};
+
+	/**
+	 * Differential tests of the engines: every engine solves and counts the same puzzles, and their
+	 * results have to agree with each other, keep the givens and pass the Validator. The puzzles
+	 * are the ones of a corpus, which have a single solution, and random ones, which may have none,
+	 * one or many.
+	 */
+	class TestEngines {
+		static const unsigned long Limit = 100;
+
+		TestEngines();
+
+		static void random(short unsigned int* values, unsigned long index, unsigned int& seed);
+		static unsigned long differ(Checker& checker, const short unsigned int* values, bool unique,
+			unsigned int& seed, char* solution);
+		static void variant(Checker& checker, const short unsigned int* values, const Grid& grid,
+			unsigned long solutions, const char* solution, unsigned int& seed);
+	public:
+		static void run(Checker& checker, const vector<short unsigned int>& corpus, unsigned long count,
+			unsigned int seed);
+	};
+
+	/**
+	 * Speed of an engine over the corpus.
+	 */
+	typedef struct {
+		string Engine;
+		double Rate;			// puzzles per second
+		unsigned long Nodes;	// nodes spent over the whole corpus, 0 for the engines without them
+	} Measure;
+
+	/**
+	 * Performance regression tests: the puzzles per second and the nodes of the engines over the
+	 * corpus are checked against the ones stored in a baseline file, which a run can also record.
+	 * The nodes don't depend on the machine, so any rise is a change of the algorithms and they're
+	 * always checked; the speed does, so it's only checked against a baseline recorded on the same
+	 * machine, and each build mode needs its own baseline.
+	 */
+	class TestBaseline {
+		TestBaseline();
+
+		static double speed(const string& engine, const vector<short unsigned int>& corpus, unsigned long& nodes);
+	public:
+		static string machine();
+		static void measure(const vector<short unsigned int>& corpus, vector<Measure>& measures);
+		static bool load(const char* path, vector<Measure>& baseline, string& host);
+		static bool save(const char* path, const vector<Measure>& measures);
+		static void run(Checker& checker, const vector<Measure>& measures, const vector<Measure>& baseline,
+			double slower, double nodes, bool timed);
 	};
 }
 }
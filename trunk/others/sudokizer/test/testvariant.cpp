@@ -0,0 +1,145 @@
+// See COPYING file for licensing information.
+/**
+ * \file testvariant.cpp
+ * Tests of the rules of the sudoku variants: killer cages, diagonals and windows.
+ */
+
+#include "testsudoku.h"
+#include "variant.h"
+#include <cstring>
+
+namespace std {
+namespace sudoku {
+	// A killer sudoku without givens: its cages, named by letters in the order of their first cell,
+	// their sums in the same order, and its single solution
+	static const char cages[] = "aabbbccccdaeeffghhdiieejgkhdlllmjgkhnooomjgppnqqomrrrrnsttmuvvwnssxxuuuwyyyzzzAAw";
+	static const short unsigned int sums[] = {15, 17, 20, 15, 10, 14, 19, 22, 17, 6, 8, 21, 16, 22, 25, 10, 4,
+		23, 21, 6, 25, 10, 18, 5, 12, 16, 8};
+	static const char killer[] = "534678912672195348198342567859761423426853791713924856961537284287419635345286179";
+
+	/**
+	 * Tells whether 9 cells of a grid hold the values 1 to 9.
+	 */
+	static bool holds(const short unsigned int* values, const unsigned char* cells) {
+		short unsigned int seen = 0;
+
+		for(short unsigned int i = 0; i < 9; i++)
+			if(values[cells[i]] >= 1 && values[cells[i]] <= 9)
+				seen |= 1 << (values[cells[i]] - 1);
+
+		return seen == 0x1FF;
+	}
+
+	/**
+	 * Tells whether a grid holds the values 1 to 9 in every row, column and box, and in the
+	 * diagonals or the windows if asked for.
+	 */
+	static bool solved(const short unsigned int* values, bool diagonals, bool windows) {
+		bool valid = true;
+
+		for(short unsigned int u = 0; u < 9 && valid; u++) {
+			unsigned char row[9], column[9], box[9], main[9], anti[9], window[9];
+
+			for(short unsigned int i = 0; i < 9; i++) {
+				row[i] = u * 9 + i;
+				column[i] = i * 9 + u;
+				box[i] = (u / 3 * 3 + i / 3) * 9 + u % 3 * 3 + i % 3;
+				main[i] = i * 9 + i;
+				anti[i] = i * 9 + 8 - i;
+				window[i] = (1 + u / 2 % 2 * 4 + i / 3) * 9 + 1 + u % 2 * 4 + i % 3;
+			}
+
+			valid = holds(values, row) && holds(values, column) && holds(values, box) &&
+				(!diagonals || (holds(values, main) && holds(values, anti))) && (!windows || u >= 4 || holds(values, window));
+		}
+
+		return valid;
+	}
+
+	/**
+	 * Runs the tests of the Variant class.
+	 * \arg		checker	record of the checks
+	 */
+	void TestVariant::run(Checker& checker) {
+		short unsigned int empty[81] = {0}, values[81], classic[81];
+
+		for(short unsigned int c = 0; c < 81; c++)
+			classic[c] = killer[c] - '0';
+
+		{
+			// The values which can fill the cells of a cage
+			SUDOKU_CHECK(checker, Variant::cageOptions(2, 3, 0x1FF) == 0x3, "cage options of 2 cells adding up to 3");
+			SUDOKU_CHECK(checker, Variant::cageOptions(3, 24, 0x1FF) == 0x1C0, "cage options of 3 cells adding up to 24");
+			SUDOKU_CHECK(checker, Variant::cageOptions(9, 45, 0x1FF) == 0x1FF, "cage options of 9 cells adding up to 45");
+			SUDOKU_CHECK(checker, Variant::cageOptions(2, 3, 0x1FE) == 0 && Variant::cageOptions(2, 18, 0x1FF) == 0,
+				"cage options without any set of values");
+		}
+
+		{
+			Variant variant;
+			const unsigned char pair[] = {0, 1}, repeated[] = {2, 2}, taken[] = {1, 2}, outside[] = {3, 81},
+				other[] = {3, 4};
+
+			SUDOKU_CHECK(checker, variant.addCage(pair, 2, 3) && variant.cages() == 1, "cage added");
+			SUDOKU_CHECK(checker, !variant.addCage(repeated, 2, 5), "cage with a repeated cell");
+			SUDOKU_CHECK(checker, !variant.addCage(taken, 2, 5), "cage with a cell already in a cage");
+			SUDOKU_CHECK(checker, !variant.addCage(outside, 2, 5), "cage with a cell out of the board");
+			SUDOKU_CHECK(checker, !variant.addCage(other, 2, 2) && !variant.addCage(other, 2, 18) &&
+				!variant.addCage(other, 0, 0), "cage with an impossible sum");
+			SUDOKU_CHECK(checker, variant.cages() == 1 && variant.addCage(other, 2, 17), "cage added after the rejected ones");
+		}
+
+		{
+			// The cages alone leave a single solution
+			Variant variant;
+			bool added = true;
+
+			for(short unsigned int k = 0; k < sizeof(sums) / sizeof(sums[0]); k++) {
+				unsigned char cells[9];
+				short unsigned int size = 0;
+				char name = k < 26 ? 'a' + k : 'A' + k - 26;
+
+				for(short unsigned int c = 0; c < 81; c++)
+					if(cages[c] == name && size < 9)
+						cells[size++] = c;
+				added = added && variant.addCage(cells, size, sums[k]);
+			}
+
+			memcpy(values, empty, sizeof(values));
+			SUDOKU_CHECK(checker, added && variant.count(empty, 2) == 1 && variant.solve(values) &&
+				memcmp(values, classic, sizeof(values)) == 0, "killer sudoku solved");
+		}
+
+		{
+			// An X-sudoku and a windoku are solved with their extra units, which a classic solution
+			// breaks
+			Variant x, windoku;
+
+			x.addDiagonals();
+			windoku.addWindows();
+			SUDOKU_CHECK(checker, x.units() == 29 && windoku.units() == 31, "units of the X-sudoku and of the windoku");
+			SUDOKU_CHECK(checker, !solved(classic, true, false) && x.count(classic) == 0 &&
+				!solved(classic, false, true) && windoku.count(classic) == 0, "classic solution of an X-sudoku or a windoku");
+
+			memcpy(values, empty, sizeof(values));
+			SUDOKU_CHECK(checker, x.solve(values) && solved(values, true, false), "X-sudoku solved");
+
+			// Every other value of the solution as the givens
+			short unsigned int givens[81];
+
+			for(short unsigned int c = 0; c < 81; c++)
+				givens[c] = c % 2 == 0 ? values[c] : 0;
+			memcpy(values, givens, sizeof(values));
+
+			bool kept = x.solve(values) && solved(values, true, false);
+
+			for(short unsigned int c = 0; c < 81 && kept; c += 2)
+				kept = values[c] == givens[c];
+			SUDOKU_CHECK(checker, kept, "X-sudoku with givens solved");
+
+			memcpy(values, empty, sizeof(values));
+			SUDOKU_CHECK(checker, windoku.solve(values) && solved(values, false, true), "windoku solved");
+		}
+	}
+}
+}